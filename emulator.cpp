@@ -20,6 +20,8 @@
 
 
 #include "mmu.cpp"
+#include "jit.cpp"
+#include "logring.cpp"
 #include"argparse/argparse.hpp"
 
 
@@ -35,6 +37,20 @@
 
 #define INT_MAX 2147483647
 
+// Granularity of the predecode cache, in bytes of guest code.
+#define DECODE_PAGE_SIZE 0x1000
+// Highest log level built in. printNotifs calls above it compile to nothing, so e.g.
+// -DLOG_COMPILED_LEVEL=5 drops the per instruction traces entirely.
+#ifndef LOG_COMPILED_LEVEL
+#define LOG_COMPILED_LEVEL 7
+#endif
+// Longest run of instructions translated into a single block.
+#define MAX_BLOCK_LENGTH 64
+// Number of runs after which --jit compiles a block.
+#define JIT_THRESHOLD 16
+// Granularity of the event page bitmap, as a shift of the guest address.
+#define EVENT_PAGE_SHIFT 12
+
 
 const short int MIP_ISA_32 = 1;
 
@@ -47,6 +63,18 @@ const short int RTYPE = 1;
 const short int ITYPE = 2;
 const short int JTYPE = 3;
 
+// How a translated block ends
+const short int BLOCK_FALLTHROUGH = 0;
+const short int BLOCK_BRANCH = 1; // b* instructions, the delay slot runs from the block
+const short int BLOCK_JUMP = 2; // j, jal, jr, jalr, which run their own delay slot
+
+// What runEmulation has to look at before running a pc, see buildEventTable
+const short int EVENT_BLOCK_START = 1; // Start of a Binary Ninja basic block
+const short int EVENT_HOOK = 2; // Hooked function, by name or by address
+const short int EVENT_KILLPOINT = 4;
+const short int EVENT_BREAKPOINT = 8; // ip breakpoints, and the blocks of symbol breakpoints
+const short int EVENT_DISPATCH = EVENT_HOOK | EVENT_KILLPOINT | EVENT_BREAKPOINT;
+
 // Debug oprtions
 short int SHUT_UP = 0;
 
@@ -56,6 +84,7 @@ const short int IntegerOverflow = 1;
 const short int MemoryFault = 2;
 const short int TrapFault = 3;
 const short int ReservedInstructionException = 4;
+const short int ResourceFault = 5;
 
 // Coverage Information
 std::vector<uint32_t> basicBlocks;
@@ -70,11 +99,25 @@ bool beQuietFlag = false;
 bool autoFlag = false;
 bool timer = false;
 bool batchMode = false;
+bool blockEngine = true;
+bool jitMode = false;
 clock_t startOfEmulation, endOfEmulation;
 double cpu_time_used;
 int globalLogLevel = 0;
+// Binary instruction trace for --logring, NULL when off.
+LogRing *logRing = NULL;
+
+// Logs through EmulatedCPU::logNotif. The level is checked before the arguments are
+// evaluated, so the getName strings and the varargs call only happen when printed.
+#define printNotifs(logLevel, ...) \
+	do { \
+		if ((logLevel) <= LOG_COMPILED_LEVEL && !beQuietFlag && globalLogLevel <= (logLevel)) \
+			logNotif(logLevel, __VA_ARGS__); \
+	} while (0)
 vector<uint32_t> globalKillPoints;
 char *outputfile;
+// Where to write the guest state when an exception is signalled, NULL when off.
+const char *corePath = NULL;
 int stepsize = 1;
 int testcaseIdx = 0;
 char *singleTestcase = "";
@@ -86,6 +129,21 @@ std::vector<short int> functionVirtualFunction;
 
 const short int NUM_FUNCTIONS_HOOKED = 7;
 
+// ISA widths the cpu can be specialized for. Registers are held at exactly the ISA width,
+// so a Mips32 cpu never has to mask its registers back down to 32 bits.
+struct Mips32
+{
+	typedef uint32_t Word;
+	static constexpr bool is64bit = false;
+};
+
+struct Mips64
+{
+	typedef uint64_t Word;
+	static constexpr bool is64bit = true;
+};
+
+template <class Isa>
 class EmulatedCPU
 {
 	public:
@@ -95,12 +153,82 @@ class EmulatedCPU
 		// during instruction time by any pseudocode statement, it is automatically incremented by four.
 		// Read more info when working with this.
 		uint64_t pc;
-		bool is64bit = false;
+		typedef typename Isa::Word Word;
+		static constexpr bool is64bit = Isa::is64bit;
 		BinaryView* bv;
 		// REGISTERS
 
+		// The fields of one instruction. Handlers take these by value, so they arrive in
+		// registers instead of being stored to and reloaded from the cpu.
+		struct Operands
+		{
+			uint32_t instruction;
+			uint8_t rs;
+			uint8_t rt;
+			uint8_t rd;
+			uint8_t sa;
+			uint16_t immediate;
+			int16_t signedImmediate;
+		};
+
 		// Hacky solution I do not understand which allows us to have a function table.
-		typedef void (EmulatedCPU::* const funct)(uint32_t);
+		typedef void (EmulatedCPU::* const funct)(Operands);
+		// Same as funct but assignable, for the handler pointers kept in decoded records.
+		typedef void (EmulatedCPU::* handler_t)(Operands);
+		// Hooked library functions, which do not decode an instruction.
+		typedef void (EmulatedCPU::* const hook_t)(uint32_t);
+		// A block compiled by --jit. Takes the cpu and its gpr[] base, returns how many of its
+		// instructions ran after the last one it handed back to the interpreter.
+		typedef uint32_t (*native_t)(EmulatedCPU *, Word *);
+#ifdef THREADED_DISPATCH
+		// A handler resolved to a plain function taking the cpu as its first argument.
+		typedef void (*dispatch_t)(EmulatedCPU *, Operands);
+#endif
+
+		// A predecoded instruction. Executable pages are decoded once into these records
+		// and runEmulation dispatches straight from them instead of fetching the word through
+		// the MMU and re-extracting the fields every time.
+		struct DecodedInstruction : Operands
+		{
+			handler_t handler;
+#ifdef THREADED_DISPATCH
+			// handler, already bound, so dispatching it is a plain indirect call.
+			dispatch_t dispatch;
+#endif
+		};
+		// A superinstruction, see fuseBlock. Runs the record it is given and the one after it.
+		typedef void (EmulatedCPU::* fused_t)(const DecodedInstruction *);
+
+		// A straight-line run of guest code translated once out of the decoded records. It
+		// ends with a branch or jump and its delay slot, or just before the next basic block
+		// start, so the bookkeeping runEmulation does per instruction only happens at exits.
+		struct TranslatedBlock
+		{
+			uint32_t start;
+			short int terminator;
+			int bodyLength; // Instructions ahead of the branch or jump
+			int iterations; // runEmulation loop passes this block stands in for
+			bool needsDispatch; // Hooks, killpoints or breakpoints sit on the first instruction
+			DecodedInstruction *code;
+			// Superinstructions by body index, or NULL if nothing in the block fused.
+			fused_t *fused;
+			// The last two successors seen, so hot paths chain without a map lookup.
+			uint32_t exitPC[2];
+			TranslatedBlock *exitBlock[2];
+			// Runs so far, and the compiled body once --jit finds the block hot.
+			int executions;
+			native_t native;
+		};
+
+		// Everything runEmulation does at one pc, gathered once at load instead of searching the
+		// block, hook, killpoint and breakpoint lists on every pass.
+		struct PCEvent
+		{
+			short int flags = 0;
+			int block = 0; // Index into basicBlocks and basicBlockNames
+			std::vector<short int> nameHooks; // Hooks matching the name of the block's function
+			int addressHook = -1; // Index into functionVirtualAddress
+		};
 		
 		// A list of functions that are rtypes index by their ALU code.
 		// Indexed by their ALU code.
@@ -448,7 +576,7 @@ class EmulatedCPU
 		// These are function hooks included with the emulator, used
 		// for common libc functions which are problematic to fully
 		// emulate.
-		const EmulatedCPU::funct static_function_hooks[NUM_FUNCTIONS_HOOKED] = {
+		const EmulatedCPU::hook_t static_function_hooks[NUM_FUNCTIONS_HOOKED] = {
 			&EmulatedCPU::hooked_libc_write,
 			&EmulatedCPU::hooked_libc_malloc,	
 			&EmulatedCPU::hooked_libc_free,	
@@ -472,15 +600,9 @@ class EmulatedCPU
 		};
 
 		// Registers and Instruction Fields
-		uint64_t gpr[32];
-		uint64_t hwr[32];
-		uint8_t rs; // 1st Source
-		uint8_t rt; // 2nd Source
-		uint8_t rd; // Register
-		uint8_t sa; // Shift Amount
-		uint64_t LO, HI; // Multiplication and division registers
-		uint16_t immediate; // Immediate
-		int16_t signedImmediate; // Immediate
+		Word gpr[32];
+		Word hwr[32];
+		Word LO, HI; // Multiplication and division registers
 		vector<uint64_t> hookedFunctions;
 
 		//Meta
@@ -491,6 +613,8 @@ class EmulatedCPU
 		char* instructions; //unused
 		int32_t tgt_offset = 0;
 		uint64_t instructionsRun = 0;
+		// Instructions run as part of a superinstruction, for the --timer report.
+		uint64_t fusedRun = 0;
 		uint32_t endOfMain, startOfMain;
 		bool checkBreakPoints = false;
 		vector<uint32_t> instructionPointerBreakpoints;
@@ -498,10 +622,45 @@ class EmulatedCPU
 
 		int32_t mipsTarget = 32;
 		bool debugPrint = true;
-		
+
+		// Predecode cache, keyed by the guest address of each DECODE_PAGE_SIZE page.
+		// The last page touched is remembered so straight-line code skips the map lookup.
+		std::unordered_map<uint32_t, DecodedInstruction*> decodedPages;
+		DecodedInstruction *lastDecoded = NULL;
+		uint32_t lastDecodedPage = 0;
+		DecodedInstruction unalignedDecoded;
+
+		// Block cache, keyed by guest start address. NULL entries mark addresses which
+		// have to run one instruction at a time.
+		std::unordered_map<uint32_t, TranslatedBlock*> translatedBlocks;
+		// Event table, keyed by pc. Every basic block start has an entry, so these are also the
+		// addresses blocks must not run through. eventPages has a bit per page holding any
+		// EVENT_DISPATCH entry, so hasEvent rarely has to hash.
+		std::unordered_map<uint32_t, PCEvent> eventTable;
+		std::vector<bool> eventPages;
+		bool eventTableBuilt = false;
+		// Host code for --jit, created on first use.
+		CodeCache *codeCache = NULL;
+
+		// Registers saved by snapshot(), the MMU keeps the memory side.
+		struct CPUSnapshot
+		{
+			uint64_t pc;
+			Word gpr[32];
+			Word hwr[32];
+			Word LO, HI;
+			bool instructionNullify;
+			bool validState;
+			bool delaySlot;
+			int32_t tgt_offset;
+			uint64_t instructionsRun;
+		};
+		CPUSnapshot savedState;
+		bool hasSnapshot = false;
 
 
-		EmulatedCPU(bool is64bit, BinaryView* bc)
+
+		EmulatedCPU(BinaryView* bc)
 		{
 			bv = bc;
 			//fflush(stdout);
@@ -568,10 +727,105 @@ class EmulatedCPU
 			
 		}
 
-		 void replaceEmulatedCPU(bool is64bit, BinaryView* bc)
+		CPUSnapshot saveRegisters()
+		{
+			CPUSnapshot state;
+			state.pc = pc;
+			memcpy(state.gpr, gpr, sizeof(gpr));
+			memcpy(state.hwr, hwr, sizeof(hwr));
+			state.LO = LO;
+			state.HI = HI;
+			state.instructionNullify = instructionNullify;
+			state.validState = validState;
+			state.delaySlot = delaySlot;
+			state.tgt_offset = tgt_offset;
+			state.instructionsRun = instructionsRun;
+			return state;
+		}
+
+		void loadRegisters(const CPUSnapshot &state)
+		{
+			pc = state.pc;
+			memcpy(gpr, state.gpr, sizeof(gpr));
+			memcpy(hwr, state.hwr, sizeof(hwr));
+			LO = state.LO;
+			HI = state.HI;
+			instructionNullify = state.instructionNullify;
+			validState = state.validState;
+			delaySlot = state.delaySlot;
+			tgt_offset = state.tgt_offset;
+			instructionsRun = state.instructionsRun;
+		}
+
+		// Saves the registers and starts journaling guest memory, so restore() can bring the
+		// whole guest back to this point without rebuilding it from the BinaryView.
+		void snapshot()
+		{
+			savedState = saveRegisters();
+			memUnit->snapshot();
+			hasSnapshot = true;
+		}
+
+		// Goes back to the last snapshot(). Only the memory written since is copied.
+		bool restore()
+		{
+			if(!hasSnapshot || !memUnit->restore())
+				return false;
+			loadRegisters(savedState);
+			return true;
+		}
+
+		// Writes the whole guest state to path as a core file: a CoreHeader, the registers,
+		// then every region memUnit has mapped, see MMU::writeCore.
+		bool writeCore(const char *path)
+		{
+			FILE *fp = fopen(path, "wb");
+			if(fp == NULL)
+			{
+				printf("Could not open the core file %s\n", path);
+				return false;
+			}
+			CoreHeader header = {CORE_MAGIC, CORE_VERSION, is64bit, memUnit->bv->GetEntryPoint(), memUnit->layoutHash()};
+			CPUSnapshot state = saveRegisters();
+			fwrite(&header, sizeof(header), 1, fp);
+			fwrite(&state, sizeof(state), 1, fp);
+			bool written = memUnit->writeCore(fp);
+			written = fclose(fp) == 0 && written;
+			if(!written)
+				printf("Could not write the core file %s\n", path);
+			return written;
+		}
+
+		// Loads a core file written by writeCore for the same binary, so emulation can resume
+		// where it was written or the state can be inspected in the debugger.
+		bool readCore(const char *path)
+		{
+			FILE *fp = fopen(path, "rb");
+			if(fp == NULL)
+			{
+				printf("Could not open the core file %s\n", path);
+				return false;
+			}
+			CoreHeader header;
+			CPUSnapshot state;
+			bool read = fread(&header, sizeof(header), 1, fp) == 1 && header.magic == CORE_MAGIC
+				&& header.version == CORE_VERSION && header.is64bit == is64bit
+				&& header.entryPoint == memUnit->bv->GetEntryPoint() && header.layout == memUnit->layoutHash()
+				&& fread(&state, sizeof(state), 1, fp) == 1 && memUnit->readCore(fp);
+			fclose(fp);
+			if(!read)
+			{
+				printf("%s is not a core file of this binary\n", path);
+				return false;
+			}
+			loadRegisters(state);
+			hasSnapshot = false;
+			return true;
+		}
+
+		// Loads a different binary. Restarting the same one is restore()'s job.
+		 void replaceEmulatedCPU(BinaryView* bc)
 		 {
-			rs = 0; rt = 0; rd = 0; sa = 0;
-			immediate = 0; signedImmediate = 0;
 			LO = 0; HI = 0;
 			instructionNullify = false;
 			validState = true;
@@ -586,8 +840,17 @@ class EmulatedCPU
 
 
 			bv = bc;
+			flushBlockCache();
+			flushDecodeCache();
 			memUnit->MMUFree();
-			memUnit = new MMU(is64bit, bc, outputfile);
+			delete memUnit;
+			memUnit = new MMU(is64bit, bc, 0, outputfile);
+			hasSnapshot = false;
+			basicBlocks.clear();
+			basicBlockNames.clear();
+			functionVirtualAddress.clear();
+			functionVirtualFunction.clear();
+			eventTableBuilt = false;
 			int i;
 			pc = 0;
 			for (i = 0; i < 32; i++)
@@ -654,6 +917,8 @@ class EmulatedCPU
 				printf("\nTotal time for emulation: %f seconds\n", cpu_time_used);
 				printf("Instruction count: %x\n", instructionsRun);
 				printf("Instructions per second: %f inst/s\n", instructionsRun/cpu_time_used);
+				printf("Fused instructions: %llu (%.1f%%)\n", (unsigned long long) fusedRun,
+					instructionsRun == 0 ? 0.0 : 100.0 * fusedRun / instructionsRun);
 			}
 
 			// TODO: Import please no steppy.
@@ -661,6 +926,7 @@ class EmulatedCPU
 			int next, skip = 0;
 			if(SHUT_UP)
 			{
+				memUnit->printUsage();
 				printf("Gracefully exiting.\n");
 				BNShutdown();
 				//system("clear");
@@ -720,7 +986,15 @@ class EmulatedCPU
 
 		void signalException(int excpt)
 		{
+			// Memory the MMU refused because a resource limit was exceeded
+			if(excpt == MemoryFault && memUnit->limitHit != LIMIT_NONE)
+				excpt = ResourceFault;
 			printNotifs(1,"Exception occured! [%d]\n", excpt);
+			// An interactive run reports its usage when it exits, but show what was exceeded now
+			if(excpt == ResourceFault || autoFlag)
+				memUnit->printUsage();
+			if(corePath != NULL)
+				writeCore(corePath);
 			if(autoFlag)
 			{
 				BNShutdown();
@@ -737,7 +1011,7 @@ class EmulatedCPU
 			uint32_t retVal = 0;
 			
 			
-			if(!memUnit->segSearch(PC).executable)
+			if(!memUnit->isExecutable(PC))
 			{
 				signalException(MemoryFault);
 			}
@@ -766,21 +1040,720 @@ class EmulatedCPU
 			return getInstruction(pc + 4);
 		}
 
+		// Splits an instruction word into its fields and picks the handler out of the
+		// rtype/regimm/otype tables.
+		void decodeInstruction(uint32_t instruction, DecodedInstruction *decoded)
+		{
+			decoded->instruction = instruction;
+			decoded->rs = (instruction & 0x3E00000) >> 21;
+			decoded->rt = (instruction & 0x1F0000) >> 16;
+			decoded->rd = (instruction & 0xf800) >> 11;
+			decoded->sa = (instruction & 0x7c0) >> 6;
+			decoded->immediate = instruction & 0xffff;
+			decoded->signedImmediate = decoded->immediate;
+
+			// If the upper 26-31 bits are set to zero, then, we have an R-Type instruction
+			if ((instruction & 0xfc000000) == 0)
+				decoded->handler = inst_handlers_rtypes[(instruction & 0b111111)];
+			// If the upper 26-31 bits are set to one, then, we have a REGIMM instruction
+			else if ((instruction & 0xfc000000) >> 26 == 1)
+				decoded->handler = inst_handlers_regimm[((instruction & 0x1f0000) >> 16)];
+			else
+				decoded->handler = inst_handlers_otypes[(instruction & 0xfc000000) >> 26];
+#ifdef THREADED_DISPATCH
+			bindHandler(decoded, decoded->handler);
+#endif
+		}
+
+		// Sets the handler of a decoded record, resolving it to a plain function pointer for
+		// threaded dispatch. This relies on GCC's bound member function extension, which is
+		// fine as EmulatedCPU has no virtual functions.
+		void bindHandler(DecodedInstruction *decoded, handler_t handler)
+		{
+			decoded->handler = handler;
+#ifdef THREADED_DISPATCH
+			decoded->dispatch = (dispatch_t)(this->*handler);
+#endif
+		}
+
+		// Decodes every word of the page starting at pageBase. Each run of fetchable words is
+		// read from the binary in one go; words that cannot be fetched get a handler that raises
+		// the fault when (and only if) they are executed, and words in writable code are
+		// refetched each time so stores into them are still seen.
+		DecodedInstruction* decodePage(uint32_t pageBase)
+		{
+			DecodedInstruction *page = new DecodedInstruction[DECODE_PAGE_SIZE / 4];
+			unsigned char *bytes = (unsigned char *) calloc(DECODE_PAGE_SIZE, sizeof(char));
+			char *kind = (char *) calloc(DECODE_PAGE_SIZE / 4, sizeof(char));
+			int i, runStart;
+
+			// 0 is fetchable, 1 is outside of executable memory, 2 is writable code.
+			for (i = 0; i < DECODE_PAGE_SIZE / 4; i++)
+			{
+				uint32_t address = pageBase + (i * 4);
+				segment seg = memUnit->segSearch(address);
+				if (!seg.executable || !memUnit->isInBinary(address))
+					kind[i] = 1;
+				else if (seg.writable)
+					kind[i] = 2;
+			}
+
+			for (i = 0; i < DECODE_PAGE_SIZE / 4; i = runStart)
+			{
+				for (runStart = i; runStart < DECODE_PAGE_SIZE / 4 && kind[runStart] == 0; runStart++);
+				if (runStart > i)
+					bv->Read(bytes + (i * 4), pageBase + (i * 4), (runStart - i) * 4);
+				if (runStart == i)
+					runStart++;
+			}
+
+			for (i = 0; i < DECODE_PAGE_SIZE / 4; i++)
+			{
+				uint32_t word = 0;
+				word += (bytes[i * 4] << 24);
+				word += (bytes[i * 4 + 1] << 16);
+				word += (bytes[i * 4 + 2] << 8);
+				word += (bytes[i * 4 + 3]);
+
+				decodeInstruction(word, &page[i]);
+				if (kind[i] == 1)
+					bindHandler(&page[i], &EmulatedCPU::fetchFault);
+				else if (kind[i] == 2)
+					bindHandler(&page[i], &EmulatedCPU::refetch);
+			}
+
+			free(bytes);
+			free(kind);
+			decodedPages[pageBase] = page;
+			return page;
+		}
+
+		// Returns the decoded record for the instruction at PC, decoding its page on first use.
+		DecodedInstruction* getDecoded(uint64_t PC)
+		{
+			if (PC & 3)
+			{
+				// Misaligned fetches are rare enough to go through the slow path every time.
+				decodeInstruction(getInstruction(PC), &unalignedDecoded);
+				return &unalignedDecoded;
+			}
+
+			uint32_t pageBase = PC & ~(uint64_t)(DECODE_PAGE_SIZE - 1);
+			if (lastDecoded == NULL || pageBase != lastDecodedPage)
+			{
+				auto found = decodedPages.find(pageBase);
+				if (found != decodedPages.end())
+					lastDecoded = found->second;
+				else
+					lastDecoded = decodePage(pageBase);
+				lastDecodedPage = pageBase;
+			}
+			return &lastDecoded[(PC & (DECODE_PAGE_SIZE - 1)) >> 2];
+		}
+
+		// Drops every decoded page, e.g. when a new binary is loaded.
+		void flushDecodeCache()
+		{
+			for (auto& page : decodedPages)
+				delete[] page.second;
+			decodedPages.clear();
+			lastDecoded = NULL;
+		}
+
+		// Handler for words outside of executable memory.
+		void fetchFault(Operands op)
+		{
+			signalException(MemoryFault);
+		}
+
+		// Handler for words in writable code, which may have changed since they were decoded.
+		void refetch(Operands op)
+		{
+			DecodedInstruction current;
+			decodeInstruction(getInstruction(pc), &current);
+			runDecoded(&current);
+		}
+
+		// Which kind of control transfer a handler performs, if any.
+		short int controlType(handler_t handler)
+		{
+			if (handler == &EmulatedCPU::j || handler == &EmulatedCPU::jal ||
+				handler == &EmulatedCPU::jr || handler == &EmulatedCPU::jalr)
+				return BLOCK_JUMP;
+			if (handler == &EmulatedCPU::beq || handler == &EmulatedCPU::bne ||
+				handler == &EmulatedCPU::blez || handler == &EmulatedCPU::bgtz ||
+				handler == &EmulatedCPU::beql || handler == &EmulatedCPU::bnel ||
+				handler == &EmulatedCPU::blezl || handler == &EmulatedCPU::bgtzl ||
+				handler == &EmulatedCPU::bltz || handler == &EmulatedCPU::bgez ||
+				handler == &EmulatedCPU::bltzl || handler == &EmulatedCPU::bgezl ||
+				handler == &EmulatedCPU::bltzal || handler == &EmulatedCPU::bgezal ||
+				handler == &EmulatedCPU::bltzall || handler == &EmulatedCPU::bgezall)
+				return BLOCK_BRANCH;
+			return BLOCK_FALLTHROUGH;
+		}
+
+		// Builds the event table from the basic blocks, hooks, killpoints and breakpoints. Symbol
+		// breakpoints are resolved here to the blocks of their function.
+		void buildEventTable()
+		{
+			eventTable.clear();
+			eventPages.assign((size_t) 1 << (32 - EVENT_PAGE_SHIFT), false);
+			for (int i = 0; i < basicBlocks.size(); i++)
+			{
+				PCEvent& event = eventTable[basicBlocks[i]];
+				// Blocks shared between functions keep the first name, as the old search did.
+				if (event.flags & EVENT_BLOCK_START)
+					continue;
+				event.flags |= EVENT_BLOCK_START;
+				event.block = i;
+				for (int j = 0; j < functionVirtualFunction.size(); j++)
+				{
+					if (basicBlockNames[i] == static_function_hook_matching[functionVirtualFunction[j]])
+					{
+						event.flags |= EVENT_HOOK;
+						event.nameHooks.push_back(functionVirtualFunction[j]);
+					}
+				}
+				for (char *s : symbolBreakpoints)
+				{
+					if (basicBlockNames[i] == s)
+						event.flags |= EVENT_BREAKPOINT;
+				}
+			}
+			// Walked backwards so the first hook on an address wins.
+			for (int i = functionVirtualAddress.size() - 1; i >= 0; i--)
+			{
+				PCEvent& event = eventTable[functionVirtualAddress[i]];
+				event.flags |= EVENT_HOOK;
+				event.addressHook = i;
+			}
+			for (uint32_t address : globalKillPoints)
+				eventTable[address].flags |= EVENT_KILLPOINT;
+			for (uint32_t address : instructionPointerBreakpoints)
+				eventTable[address].flags |= EVENT_BREAKPOINT;
+			for (auto& entry : eventTable)
+			{
+				if (entry.second.flags & EVENT_DISPATCH)
+					eventPages[entry.first >> EVENT_PAGE_SHIFT] = true;
+			}
+			eventTableBuilt = true;
+		}
+
+		PCEvent* findEvent(uint32_t address)
+		{
+			auto found = eventTable.find(address);
+			if (found == eventTable.end())
+				return NULL;
+			return &found->second;
+		}
+
+		// Whether runEmulation has to see address before it executes (hooks, killpoints, breakpoints).
+		bool hasEvent(uint32_t address)
+		{
+			if (!eventPages[address >> EVENT_PAGE_SHIFT])
+				return false;
+			PCEvent *event = findEvent(address);
+			return event != NULL && (event->flags & EVENT_DISPATCH);
+		}
+
+		// Translates the block starting at address. Returns NULL if the first instruction
+		// cannot start a block (writable code, or a branch that cannot be fused with its
+		// delay slot), in which case runEmulation steps it on its own.
+		TranslatedBlock* translateBlock(uint32_t address)
+		{
+			if (address & 3)
+				return NULL;
+			if (!eventTableBuilt)
+				buildEventTable();
+
+			std::vector<DecodedInstruction> code;
+			short int terminator = BLOCK_FALLTHROUGH;
+			uint32_t current = address;
+			while (code.size() < MAX_BLOCK_LENGTH)
+			{
+				if (current != address && eventTable.count(current))
+					break;
+				DecodedInstruction decoded = *getDecoded(current);
+				if (decoded.handler == &EmulatedCPU::refetch)
+					break;
+				short int type = controlType(decoded.handler);
+				if (type != BLOCK_FALLTHROUGH)
+				{
+					DecodedInstruction delay = *getDecoded(current + 4);
+					// A branch in a delay slot, or an event on a b* delay slot (which runEmulation
+					// would have seen as its own pass), is left to the single step path.
+					if (delay.handler == &EmulatedCPU::refetch || controlType(delay.handler) != BLOCK_FALLTHROUGH)
+						break;
+					if (type == BLOCK_BRANCH && hasEvent(current + 4))
+						break;
+					code.push_back(decoded);
+					code.push_back(delay);
+					terminator = type;
+					break;
+				}
+				code.push_back(decoded);
+				current += 4;
+			}
+			if (code.empty())
+				return NULL;
+
+			TranslatedBlock *block = new TranslatedBlock;
+			block->start = address;
+			block->terminator = terminator;
+			block->bodyLength = code.size();
+			block->iterations = code.size();
+			if (terminator == BLOCK_BRANCH)
+				block->bodyLength -= 2;
+			else if (terminator == BLOCK_JUMP)
+			{
+				// The delay slot runs inside the jump handler and is not a pass of its own.
+				block->bodyLength -= 2;
+				block->iterations -= 1;
+			}
+			block->needsDispatch = hasEvent(address);
+			block->code = new DecodedInstruction[code.size()];
+			std::copy(code.begin(), code.end(), block->code);
+			block->exitPC[0] = block->exitPC[1] = 0;
+			block->exitBlock[0] = block->exitBlock[1] = NULL;
+			block->executions = 0;
+			block->native = NULL;
+			fuseBlock(block);
+			return block;
+		}
+
+		// Peephole pass over a block body, pairing common compiler idioms into one
+		// superinstruction. Each pair has the same effect as running its two records in turn.
+		void fuseBlock(TranslatedBlock *block)
+		{
+			block->fused = NULL;
+			for (int i = 0; i + 1 < block->bodyLength; i++)
+			{
+				const DecodedInstruction *first = &block->code[i];
+				const DecodedInstruction *second = &block->code[i + 1];
+				fused_t fused = NULL;
+				// Words that fault or are refetched on every run keep their own records.
+				if (isUnfusable(first->handler) || isUnfusable(second->handler))
+					continue;
+				// Address materialization, lui rt then addiu or ori off rt.
+				if (first->handler == &EmulatedCPU::lui && second->handler == &EmulatedCPU::addiu && second->rs == first->rt)
+					fused = &EmulatedCPU::luiAddiu;
+				else if (first->handler == &EmulatedCPU::lui && second->handler == &EmulatedCPU::ori && second->rs == first->rt)
+					fused = &EmulatedCPU::luiOri;
+				// Frame setup, addiu sp then a store such as sw ra.
+				else if (first->handler == &EmulatedCPU::addiu && second->handler == &EmulatedCPU::sw)
+					fused = &EmulatedCPU::addiuStore;
+				// Load delay slot and other nop padding.
+				else if (second->handler == &EmulatedCPU::sll && second->instruction == 0)
+					fused = &EmulatedCPU::thenNop;
+				if (fused == NULL)
+					continue;
+				if (block->fused == NULL)
+					block->fused = new fused_t[block->bodyLength]();
+				block->fused[i] = fused;
+				// The second record is consumed by the pair.
+				i++;
+			}
+		}
+
+		bool isUnfusable(handler_t handler)
+		{
+			return handler == &EmulatedCPU::fetchFault || handler == &EmulatedCPU::refetch;
+		}
+
+		void luiAddiu(const DecodedInstruction *decoded)
+		{
+			gpr[decoded[0].rt] = (int32_t) decoded[0].immediate << 16;
+			pc += 4;
+			instructionsRun++;
+			gpr[decoded[1].rt] = gpr[decoded[1].rs] + decoded[1].signedImmediate;
+		}
+
+		void luiOri(const DecodedInstruction *decoded)
+		{
+			gpr[decoded[0].rt] = (int32_t) decoded[0].immediate << 16;
+			pc += 4;
+			instructionsRun++;
+			gpr[decoded[1].rt] = (uint64_t) decoded[1].immediate | gpr[decoded[1].rs];
+		}
+
+		void addiuStore(const DecodedInstruction *decoded)
+		{
+			gpr[decoded[0].rt] = gpr[decoded[0].rs] + decoded[0].signedImmediate;
+			pc += 4;
+			instructionsRun++;
+			// Stores can fault, so the second half runs with pc and the count at the store.
+			runDecoded(&decoded[1]);
+		}
+
+		void thenNop(const DecodedInstruction *decoded)
+		{
+			runDecoded(&decoded[0]);
+			pc += 4;
+			instructionsRun++;
+		}
+
+		TranslatedBlock* getBlock(uint32_t address)
+		{
+			auto found = translatedBlocks.find(address);
+			if (found != translatedBlocks.end())
+				return found->second;
+			TranslatedBlock *block = translateBlock(address);
+			translatedBlocks[address] = block;
+			return block;
+		}
+
+		// Drops every translated block. Needed whenever the boundaries change, e.g. when a
+		// breakpoint is set, as well as when a new binary is loaded.
+		void flushBlockCache()
+		{
+			for (auto& block : translatedBlocks)
+			{
+				if (block.second != NULL)
+				{
+					delete[] block.second->code;
+					delete[] block.second->fused;
+					delete block.second;
+				}
+			}
+			translatedBlocks.clear();
+			if (codeCache != NULL)
+				codeCache->reset();
+		}
+
+		// Runs one translated block and returns the block execution continues in, or NULL if
+		// that address has no block. The straight-line body just advances pc; the delay slot and
+		// branch target bookkeeping is only done for the terminating branch or jump.
+		TranslatedBlock* runBlock(TranslatedBlock *block)
+		{
+			int i = block->bodyLength;
+			// Compiled code and superinstructions skip the per instruction log output and the
+			// log ring, so they are only used when neither is wanted.
+			bool quiet = (beQuietFlag || globalLogLevel > 7) && logRing == NULL;
+			if (block->native != NULL)
+				instructionsRun += block->native(this, gpr);
+			else
+			{
+				// Only the Mips32 core is compiled.
+				if constexpr (!is64bit)
+				{
+					if (jitMode && quiet && ++block->executions == JIT_THRESHOLD)
+						compileBlock(block);
+				}
+				if (block->fused != NULL && quiet)
+				{
+					for (i = 0; i < block->bodyLength; i++)
+					{
+						pc = block->start + (i * 4);
+						if (block->fused[i] != NULL)
+						{
+							(this->*block->fused[i])(&block->code[i]);
+							fusedRun += 2;
+							i++;
+						}
+						else
+							runDecoded(&block->code[i]);
+						instructionsRun++;
+					}
+				}
+				else
+				{
+					for (i = 0; i < block->bodyLength; i++)
+					{
+						pc = block->start + (i * 4);
+						runDecoded(&block->code[i]);
+						// Kept exact per instruction, faults and exits report it from inside the handlers.
+						instructionsRun++;
+					}
+				}
+			}
+			pc = block->start + (i * 4);
+
+			if (block->terminator == BLOCK_JUMP)
+			{
+				runDecoded(&block->code[i]);
+				instructionsRun++;
+				advancePC();
+			}
+			else if (block->terminator == BLOCK_BRANCH)
+			{
+				runDecoded(&block->code[i]);
+				instructionsRun++;
+				advancePC();
+				// Likely branches that are not taken nullify the delay slot.
+				if (!instructionNullify)
+				{
+					runDecoded(&block->code[i + 1]);
+					instructionsRun++;
+				}
+				else
+					instructionNullify = false;
+				advancePC();
+			}
+
+			// Chain to the successor.
+			if (pc == block->exitPC[0] && block->exitBlock[0] != NULL)
+				return block->exitBlock[0];
+			if (pc == block->exitPC[1] && block->exitBlock[1] != NULL)
+				return block->exitBlock[1];
+			TranslatedBlock *next = getBlock(pc);
+			if (next != NULL)
+			{
+				int slot = block->exitBlock[0] == NULL ? 0 : 1;
+				block->exitPC[slot] = pc;
+				block->exitBlock[slot] = next;
+			}
+			return next;
+		}
+
+		// Called from compiled blocks for the instructions they do not translate themselves.
+		// nativeRun is how many compiled instructions ran since the last call, so the count
+		// is exact if this instruction faults.
+		static void jitInterpret(EmulatedCPU *cpu, const DecodedInstruction *decoded, uint32_t address, uint32_t nativeRun)
+		{
+			cpu->instructionsRun += nativeRun;
+			cpu->pc = address;
+			cpu->runDecoded(decoded);
+			cpu->instructionsRun++;
+		}
+
+		// Whether compileInstruction can translate this handler. Only register to register
+		// ALU work is translated; none of these can fault.
+		bool jitCompilable(handler_t handler)
+		{
+			return handler == &EmulatedCPU::addu || handler == &EmulatedCPU::addiu ||
+				handler == &EmulatedCPU::subu || handler == &EmulatedCPU::andop ||
+				handler == &EmulatedCPU::orop || handler == &EmulatedCPU::xorop ||
+				handler == &EmulatedCPU::nor || handler == &EmulatedCPU::andi ||
+				handler == &EmulatedCPU::ori || handler == &EmulatedCPU::xori ||
+				handler == &EmulatedCPU::lui || handler == &EmulatedCPU::sll ||
+				handler == &EmulatedCPU::srl || handler == &EmulatedCPU::sra ||
+				handler == &EmulatedCPU::slt || handler == &EmulatedCPU::sltu ||
+				handler == &EmulatedCPU::slti || handler == &EmulatedCPU::sltui;
+		}
+
+		// Emits one instruction. Registers are 32 bits wide in the Mips32 core these blocks
+		// are compiled for, so every result is simply stored back as a dword.
+		void compileInstruction(const DecodedInstruction *decoded)
+		{
+			handler_t handler = decoded->handler;
+			int32_t rsOffset = decoded->rs * sizeof(Word);
+			int32_t rtOffset = decoded->rt * sizeof(Word);
+			int32_t rdOffset = decoded->rd * sizeof(Word);
+
+			// rd = rs op rt
+			uint8_t registerOp = 0;
+			if (handler == &EmulatedCPU::addu) registerOp = X86_ADD_LOAD;
+			else if (handler == &EmulatedCPU::subu) registerOp = X86_SUB_LOAD;
+			else if (handler == &EmulatedCPU::andop) registerOp = X86_AND_LOAD;
+			else if (handler == &EmulatedCPU::orop || handler == &EmulatedCPU::nor) registerOp = X86_OR_LOAD;
+			else if (handler == &EmulatedCPU::xorop) registerOp = X86_XOR_LOAD;
+			if (registerOp != 0)
+			{
+				codeCache->aluLoad(X86_MOV_LOAD, rsOffset);
+				codeCache->aluLoad(registerOp, rtOffset);
+				if (handler == &EmulatedCPU::nor)
+					codeCache->notEax();
+				codeCache->storeEax(rdOffset);
+				return;
+			}
+
+			// rt = rs op immediate
+			uint8_t immediateOp = 0;
+			uint32_t operand = decoded->immediate;
+			if (handler == &EmulatedCPU::addiu)
+			{
+				immediateOp = X86_ADD_IMM;
+				operand = (int32_t) decoded->signedImmediate;
+			}
+			else if (handler == &EmulatedCPU::andi) immediateOp = X86_AND_IMM;
+			else if (handler == &EmulatedCPU::ori) immediateOp = X86_OR_IMM;
+			else if (handler == &EmulatedCPU::xori) immediateOp = X86_XOR_IMM;
+			if (immediateOp != 0)
+			{
+				codeCache->aluLoad(X86_MOV_LOAD, rsOffset);
+				codeCache->aluImmediate(immediateOp, operand);
+				codeCache->storeEax(rtOffset);
+				return;
+			}
+
+			// Set on less than. The handlers compare the registers zero extended, so these
+			// all come out unsigned.
+			if (handler == &EmulatedCPU::slt || handler == &EmulatedCPU::sltu)
+			{
+				codeCache->aluLoad(X86_MOV_LOAD, rsOffset);
+				codeCache->aluLoad(X86_CMP_LOAD, rtOffset);
+				codeCache->setBelow();
+				codeCache->storeEax(rdOffset);
+				return;
+			}
+			if (handler == &EmulatedCPU::slti || handler == &EmulatedCPU::sltui)
+			{
+				operand = handler == &EmulatedCPU::slti ? decoded->immediate : (uint32_t)(int32_t) decoded->signedImmediate;
+				codeCache->aluLoad(X86_MOV_LOAD, rsOffset);
+				codeCache->aluImmediate(X86_CMP_IMM, operand);
+				codeCache->setBelow();
+				codeCache->storeEax(rtOffset);
+				return;
+			}
+
+			if (handler == &EmulatedCPU::lui)
+			{
+				codeCache->loadEax((uint32_t) decoded->immediate << 16);
+				codeCache->storeEax(rtOffset);
+				return;
+			}
+
+			// Shifts by sa
+			codeCache->aluLoad(X86_MOV_LOAD, rtOffset);
+			if (handler == &EmulatedCPU::sll)
+				codeCache->shiftLeftEax(decoded->sa);
+			else if (handler == &EmulatedCPU::srl)
+				codeCache->shiftRightEax(decoded->sa);
+			else
+				codeCache->shiftRightArithmeticEax(decoded->sa);
+			codeCache->storeEax(rdOffset);
+		}
+
+		// Compiles the body of a hot block to x86-64 for --jit. The branch or jump ending the
+		// block, and its delay slot, are still run by runBlock.
+		void compileBlock(TranslatedBlock *block)
+		{
+			int i, translated = 0;
+			for (i = 0; i < block->bodyLength; i++)
+			{
+				if (jitCompilable(block->code[i].handler))
+					translated++;
+			}
+			if (translated == 0)
+				return;
+
+			if (codeCache == NULL)
+				codeCache = new CodeCache();
+			// Worst case per instruction is a helper call.
+			if (!codeCache->hasRoom(64 + block->bodyLength * 48) || !codeCache->beginEmit())
+				return;
+
+			codeCache->prologue();
+			uint32_t nativeRun = 0;
+			for (i = 0; i < block->bodyLength; i++)
+			{
+				const DecodedInstruction *decoded = &block->code[i];
+				if (jitCompilable(decoded->handler))
+				{
+					compileInstruction(decoded);
+					nativeRun++;
+				}
+				else
+				{
+					codeCache->callHelper((void *) &EmulatedCPU::jitInterpret, (uint64_t) decoded, block->start + (i * 4), nativeRun);
+					nativeRun = 0;
+				}
+			}
+			// Compiled instructions after the last helper call are counted by runBlock.
+			codeCache->epilogue(nativeRun);
+			if (codeCache->endEmit())
+			{
+				block->native = (native_t) codeCache->blockStart;
+				return;
+			}
+			// Nothing in the cache can be run any more
+			printf("Could not make the JIT code cache executable, running interpreted.\n");
+			for (auto& translated : translatedBlocks)
+			{
+				if (translated.second != NULL)
+					translated.second->native = NULL;
+			}
+			jitMode = false;
+		}
+
+		// Moves pc on after an instruction, taking a pending delay slot or branch target into account.
+		void advancePC()
+		{
+			//If this is the delay slot, remove the flag and do the pc
+			if (delaySlot)
+			{
+				//The instruction that just executed is a branch.
+				//So tgt_offset is loaded, but we refuse entry with delay slot
+				//The next pass is going to execute the next scheduled instruction, and then enter tgt_offset
+				delaySlot = false;
+				pc += 4;
+			}
+			//If this is not the delay slot and there's a loaded offset, (It must be the next next instruction from a Branch)
+			//execute the loaded offset
+			else if (tgt_offset != 0)
+			{
+				pc += tgt_offset;
+				tgt_offset = 0;
+			}
+			else
+				pc += 4;
+		}
+
 		// Call to bridge unimplemented instruction handlers with helpful debug information.
-		void unimplemented(uint32_t opcode)
+		void unimplemented(Operands op)
 		{
 			printNotifs(4,"Unimplemented emulation instruction was called.\n");
-			printNotifs(6,"Operation Code [0x%x], detected index:\n", opcode);
-			if ((opcode & 0xfc000000) == 0)
-				printNotifs(6,"Rtype [%d]\n", (opcode & 0b111111));
-			else if ((opcode & 0xfc000000) >> 26 == 1)
-				printNotifs(6,"Regimm [%d]\n", ((opcode & 0x1f0000) >> 16));
+			printNotifs(6,"Operation Code [0x%x], detected index:\n", op.instruction);
+			if ((op.instruction & 0xfc000000) == 0)
+				printNotifs(6,"Rtype [%d]\n", (op.instruction & 0b111111));
+			else if ((op.instruction & 0xfc000000) >> 26 == 1)
+				printNotifs(6,"Regimm [%d]\n", ((op.instruction & 0x1f0000) >> 16));
 			else
-				printNotifs(6,"Otype [%d]\n", ((opcode & 0xfc000000) >> 26));
+				printNotifs(6,"Otype [%d]\n", ((op.instruction & 0xfc000000) >> 26));
 			while(true) generallyPause();
 			return;
 		}
 
+		// Batch execution for runs that never reach the prompt. Runs until pc lands on an event
+		// address (hook, killpoint or breakpoint) or the cpu stops; runEmulation then handles that
+		// pass with all of its checks, and can still drop into the debugger from there.
+		void runHeadless()
+		{
+			uint32_t oldStackPointer = gpr[29], oldFramePointer = gpr[30];
+			while (validState)
+			{
+				if (hasEvent(pc))
+					break;
+				if (blockEngine && !instructionNullify && !delaySlot && tgt_offset == 0)
+				{
+					TranslatedBlock *block = getBlock(pc);
+					if (block != NULL)
+					{
+						while (block != NULL && validState && !block->needsDispatch)
+							block = runBlock(block);
+					}
+					else
+					{
+						runDecoded(getDecoded(pc));
+						instructionsRun++;
+						advancePC();
+					}
+				}
+				else
+				{
+					if (!instructionNullify)
+					{
+						runDecoded(getDecoded(pc));
+						instructionsRun++;
+					}
+					else
+						instructionNullify = false;
+					advancePC();
+				}
+
+				if (gpr[29] != oldStackPointer)
+				{
+					memUnit->newStackSection(gpr[29]);
+					oldStackPointer = gpr[29];
+				}
+				if (gpr[30] != oldFramePointer)
+				{
+					memUnit->newFrameSection(gpr[30]);
+					oldFramePointer = gpr[30];
+				}
+			}
+		}
+
 		// Takes in a program counter that is the entry point.
 		// Unused.
 		void runEmulation(int entryPoint)
@@ -797,12 +1770,31 @@ class EmulatedCPU
 			{
 				skip = INT_MAX;
 			}
+			buildEventTable();
+			// Nothing is printed per instruction and the prompt is never shown, so the passes
+			// between events can skip the debugger checks entirely.
+			bool headless = (SHUT_UP >= 1 || autoFlag) && (beQuietFlag || globalLogLevel > 6) && !pcoutFlag;
+			// Guest accesses that fault in the MMU arena come back here, see arenaFaultHandler.
+			sigjmp_buf faultJump;
+			sigjmp_buf *outerFaultJump = arenaFaultJump;
+			if (sigsetjmp(faultJump, 1) != 0)
+			{
+				memUnit->reportArenaFault(arenaFaultAddress);
+				signalException(MemoryFault);
+			}
+			arenaFaultJump = &faultJump;
 			//While nothing has exploded,
 			while (validState == true)
 			{
+				if (headless)
+				{
+					runHeadless();
+					if (!validState)
+						break;
+				}
 				
-				// Code to determine if we are able to find the current PC in a basic block.
-				auto findIterator = std::find(basicBlocks.begin(), basicBlocks.end(), pc);
+				// Everything to do at this pc, from the event table.
+				PCEvent *event = findEvent(pc);
 
 				if (pcoutFlag)
 				{
@@ -810,71 +1802,48 @@ class EmulatedCPU
 					fflush(PCPathFile);
 				}
 
-				if(findIterator != basicBlocks.end())
+				if(event != NULL && (event->flags & EVENT_BLOCK_START))
 				{
 					// Get the index
-					index = findIterator-basicBlocks.begin();
+					index = event->block;
 					printNotifs(6,"Current PC:  0x%lx - Start of a Basic Block in: %s\n", pc, basicBlockNames[index].c_str());
 					
-					for(int i = 0; i < functionVirtualFunction.size(); i++)
+					uint32_t hookPC = pc;
+					for(short int hook : event->nameHooks)
 					{
-						//printf("i: %d\n", i);
-						//printf("func: %d\n",functionVirtualFunction[i]);
-						//printf("%s\n", basicBlockNames[index].c_str());
-						//printf("%s\n", static_function_hook_matching[functionVirtualFunction[i]].c_str());
-						if(strcmp(basicBlockNames[index].c_str(), static_function_hook_matching[functionVirtualFunction[i]].c_str()) == 0)
-						{
-							printNotifs(5,"Found a hooked function, calling appropriate hooked implementation (prototype)!\n");
-							(this->*static_function_hooks[functionVirtualFunction[i]])(0x0);
-						}
-						
-					}				
+						printNotifs(5,"Found a hooked function, calling appropriate hooked implementation (prototype)!\n");
+						(this->*static_function_hooks[hook])(0x0);
+					}
+					// Hooks return to ra themselves, the remaining checks are for where they went.
+					if(pc != hookPC)
+						event = findEvent(pc);
 				}
 				else
 				{
 					printNotifs(6,"Current PC:  0x%lx - Last Found Basic Block in: %s\n", pc, basicBlockNames[index].c_str());
 				}
 
-				if(checkBreakPoints)
+				if(checkBreakPoints && event != NULL && (event->flags & EVENT_BREAKPOINT))
 				{
-					//uint32_t targetPC = tgt_offset == 0? pc + 4: pc + tgt_offset;
-					for(uint32_t i : instructionPointerBreakpoints)
-					{
-						if(pc == i)
-							skip = 0;
-					}
-					for(char *s : symbolBreakpoints)
-					{
-						//findIterator = std::find(basicBlocks.begin(), basicBlocks.end(), targetPC);
-						//int testindex = findIterator-basicBlocks.begin();
-						if(strcmp(s, basicBlockNames[index].c_str()) == 0)
-						{
-							skip = 0;
-						}
-					}
+					skip = 0;
 				}
 
-				if(globalKillPoints.size() != 0)
+				if(event != NULL && (event->flags & EVENT_KILLPOINT))
 				{
-					if(std::find(globalKillPoints.begin(), globalKillPoints.end(), pc) != globalKillPoints.end())
-					{
-						printf("\nEnding execution; hit global killpoint.\n");
-						BNShutdown();
-						raise(SIGKILL);
-						//generallyPause();
-					}
+					printf("\nEnding execution; hit global killpoint.\n");
+					memUnit->printUsage();
+					BNShutdown();
+					raise(SIGKILL);
+					//generallyPause();
 				}
 				
 				// Check to see if we've entered a hooked function
-				// Code to search iteratively through our hooked functions and find if PC is a hooked address.
-				
-				findIterator = std::find(functionVirtualAddress.begin(), functionVirtualAddress.end(), pc);
-				if(findIterator != functionVirtualAddress.end())
+				if(event != NULL && event->addressHook >= 0)
 				{
 					printNotifs(5,"Found a hooked function, calling appropriate hooked implementation!\n");
-					index = findIterator-functionVirtualAddress.begin();
-					printNotifs(5,"Index: [%d] name of [%s] \n", index, static_function_hook_matching[functionVirtualFunction[index]].c_str());
-					(this->*static_function_hooks[functionVirtualFunction[index]])(0x0);
+					int hookIndex = event->addressHook;
+					printNotifs(5,"Index: [%d] name of [%s] \n", hookIndex, static_function_hook_matching[functionVirtualFunction[hookIndex]].c_str());
+					(this->*static_function_hooks[functionVirtualFunction[hookIndex]])(0x0);
 					//registerDump();
 					
 					//while(true);
@@ -886,11 +1855,34 @@ class EmulatedCPU
 				//fp = fopen("pathing", "w+");
 				//fclose(fp);
 				
+				// Outside of single stepping, run whole translated blocks and chain from one to the
+				// next until one has events on its entry, which then go through the checks above.
+				if (blockEngine && !pcoutFlag && !instructionNullify && !delaySlot && tgt_offset == 0)
+				{
+					TranslatedBlock *block = getBlock(pc);
+					bool ranBlock = false;
+					while (block != NULL && validState && (SHUT_UP >= 1 || skip > block->iterations))
+					{
+						TranslatedBlock *next = runBlock(block);
+						skip -= block->iterations;
+						ranBlock = true;
+						block = next;
+						if (block != NULL && block->needsDispatch)
+							break;
+					}
+					if (ranBlock)
+					{
+						memUnit->newStackSection(gpr[29]);
+						memUnit->newFrameSection(gpr[30]);
+						printNotifs(6,"Instructions run: %lld\n\n", instructionsRun);
+						continue;
+					}
+				}
+
 				//If the instruction is not nullified, fetch and run it.
 				if (!instructionNullify)
 				{
-					uint32_t instruction = getInstruction(pc);
-					runInstruction(instruction);
+					runDecoded(getDecoded(pc));
 					
 					instructionsRun++;
 					printNotifs(6,"Instructions run: %lld\n\n", instructionsRun);
@@ -901,24 +1893,7 @@ class EmulatedCPU
 				else
 					instructionNullify = false;
 
-				//If this is the delay slot, remove the flag and do the pc
-				if (delaySlot)
-				{
-					//The instruction that just executed in the function above is a branch.
-					//So tgt_offset is loaded, but we refuse entry with delay slot
-					//The while loop is going to cycle and execute the next scheduled instruction, and then enter tgt_offset
-					delaySlot = false;
-					pc += 4;
-				}
-				//If this is not the delay slot and there's a loaded offset, (It must be the next next instruction from a Branch)
-				//execute the loaded offset
-				else if (tgt_offset != 0)
-				{
-					pc += tgt_offset;
-					tgt_offset = 0;
-				}
-				else
-					pc += 4;
+				advancePC();
 				
 				
 				//Track the changes to the stack and frame pointer
@@ -950,6 +1925,8 @@ class EmulatedCPU
 				
 				while(next == 0 && skip <= 0 && (SHUT_UP < 1))
 				{
+					// Once the debugger is in use every pass goes through the checks above.
+					headless = false;
 					printf("\n>> ");
 					scanf("%s", pweasenosteppy);
 					if(strncmp(pweasenosteppy, "mem", 3) == 0)
@@ -978,6 +1955,12 @@ class EmulatedCPU
 						scanf("%s", breaktag);
 						flags = scanCode(pweasenosteppy, 0, 0, breaktag);
 					}
+					else if(strncmp(pweasenosteppy, "core", 4) == 0)
+					{
+						char *breaktag = (char *)calloc(256, sizeof(char));
+						scanf("%s", breaktag);
+						flags = scanCode(pweasenosteppy, 0, 0, breaktag);
+					}
 					else if(strncmp(pweasenosteppy, "flag", 4) == 0)
 					{
 						char *breaktag = (char *)calloc(52, sizeof(char));
@@ -1009,7 +1992,7 @@ class EmulatedCPU
 				
 			}
 			
-
+			arenaFaultJump = outerFaultJump;
 			return;
 		}
 
@@ -1032,6 +2015,35 @@ class EmulatedCPU
 				stateDump();
 				return 0;
 			}
+			else if(strncmp(input, "snapshot", 8) == 0)
+			{
+				snapshot();
+				return 0;
+			}
+			else if(strncmp(input, "restore", 7) == 0)
+			{
+				if(!restore())
+					printNotifs(7, "No snapshot to restore\n");
+				return 0;
+			}
+			else if(strncmp(input, "core", 4) == 0)
+			{
+				if(breaktag != NULL && writeCore(breaktag))
+					printf("Wrote %s\n", breaktag);
+				return 0;
+			}
+			else if(strncmp(input, "dirty", 5) == 0)
+			{
+				memUnit->forEachDirty([](uint64_t address, uint64_t length) {
+					printf("0x%08lx - 0x%08lx\n", address, address + length - 1);
+				});
+				return 0;
+			}
+			else if(strncmp(input, "usage", 5) == 0)
+			{
+				memUnit->printUsage();
+				return 0;
+			}
 			else if(strncmp(input, "stepi", 5) == 0)
 				return 1;
 			else if(strncmp(input, "step", 4) == 0)
@@ -1055,6 +2067,8 @@ class EmulatedCPU
 					printf("0x%x\n", breakpoint);
 					instructionPointerBreakpoints.push_back(breakpoint);
 					checkBreakPoints = true;
+					buildEventTable();
+					flushBlockCache();
 					return 0;
 				}
 				//else, the breaktag is the name of a symbol
@@ -1064,6 +2078,8 @@ class EmulatedCPU
 				{
 					checkBreakPoints = true;
 					symbolBreakpoints.push_back(breaktag);
+					buildEventTable();
+					flushBlockCache();
 				}
 				else
 				{
@@ -1083,13 +2099,15 @@ class EmulatedCPU
 				{
 					instructionPointerBreakpoints.clear();
 					symbolBreakpoints.clear();
+					buildEventTable();
+					flushBlockCache();
 				}
 			}
 			else if(strncmp(input, "file", 4) == 0)
 			{
 				//filepath is in breaktag
 				Ref<BinaryView> bv = createBinjaAnalysis(breaktag);
-				replaceEmulatedCPU(false, bv);
+				replaceEmulatedCPU(bv);
 				this->runEmulation(this->startOfMain);
 				//overwrite emulatedcpu
 				//return 0;
@@ -1112,10 +2130,12 @@ class EmulatedCPU
 					fclose(PCPathFile);
 				}
 				system("clear");
+				memUnit->printUsage();
 				raise(SIGKILL);
 			}
 			else if(strncmp(input, "kill", 4) == 0)
 			{
+				memUnit->printUsage();
 				BNShutdown();
 				raise(SIGKILL);
 			}
@@ -1128,6 +2148,11 @@ class EmulatedCPU
 				printf("stepsize [#]:\n\t- Sets stepsize to [#].\n");
 				printf("reg:\n\t- Provides a register dump to the screen.\n");
 				printf("state:\n\t- Provides a diagram of the state of the program, including registers, pc, and pointers.\n");
+				printf("snapshot:\n\t- Saves the registers and memory so restore can return to this point.\n");
+				printf("restore:\n\t- Returns to the last snapshot, copying back only the memory written since.\n");
+				printf("dirty:\n\t- Lists the ranges of memory written so far.\n");
+				printf("usage:\n\t- Prints the heap, stack, dirty page and host memory use checked by the --max limits.\n");
+				printf("core [path]:\n\t- Writes the registers and memory to a core file at [path], see --loadcore.\n");
 				printf("mem [hexVal] [numBytes]:\n\t- Provides contents of memory at hexVal\n");
 				printf("break [string]:\n\t- Adds breakpoint at instruction pointed to by [string] if first char is *, otherwise adds breakpoint at symbol [string]\n");
 				printf("continue:\n\t- Continues emulation until breakpoint has been hit, otherwise continues until program ends.\n");
@@ -1147,10 +2172,11 @@ class EmulatedCPU
 				if(memUnit->isInStack(address))
 				{
 					int linePos=0, word=0;
-					int startingIndex = memUnit->stackBase-address;
-					for(int i = startingIndex;i > startingIndex - n; i--)
+					uint8_t *bytes = (uint8_t *)calloc(n, sizeof(uint8_t));
+					memUnit->copyOut(address, (char *)bytes, n, true);
+					for(int i = 0;i < n; i++)
 					{
-						printf("%02hhx", memUnit->stack[i]);
+						printf("%02hhx", bytes[i]);
 						word++;
 						linePos++;
 						if(word > 3)
@@ -1164,6 +2190,7 @@ class EmulatedCPU
 							linePos = 0;
 						}
 					}
+					free(bytes);
 				}
 				if(memUnit->MMUHeap.isInHeap(address))
 				{
@@ -1173,18 +2200,13 @@ class EmulatedCPU
 				if(memUnit->isInBinary(address))
 				{
 					printNotifs(7,"bytes:");
-					char* hold = memUnit->getEffectiveAddress(address, n, 0, 0, beQuietFlag);
-					/*if (bv->Read(hold, address, n) != n)
-					{
-						printNotifs(7, "bv read generally pause\n");
-						while(true) generallyPause(); // Why was this put here?
-					}*/
 						int linePos=0, word=0;
+						uint8_t *bytes = (uint8_t *)calloc(n, sizeof(uint8_t));
+						memUnit->copyOut(address, (char *)bytes, n, beQuietFlag);
 						printf("-\n");
 						for(int i=0;i<n;i++)
 						{
-							
-							printf("%02hhx", hold[i]);
+							printf("%02hhx", bytes[i]);
 							word++;
 							linePos++;
 							if(word > 3)
@@ -1198,6 +2220,7 @@ class EmulatedCPU
 								linePos = 0;
 							}
 						}
+						free(bytes);
 					
 				}
 			}
@@ -1223,12 +2246,10 @@ class EmulatedCPU
 			//registerDump();
 			//printNotifs(6,"Getting string address 0x%lx of size 0x%0lx.\n", gpr[5], gpr[6]);
 			//printf("Getting string address 0x%lx of size 0x%0lx.\n", gpr[5], gpr[6]);
-			char *address = memUnit->getEffectiveAddress(gpr[5], gpr[6], 17, gpr[5], beQuietFlag);
 			char *strptr = (char *)calloc(gpr[6]+1, sizeof(char));
-			strncpy(strptr, address, gpr[6]);
-			strptr[gpr[6]] = 0;
-			if(address == NULL)
+			if(!memUnit->copyOut(gpr[5], strptr, gpr[6], beQuietFlag))
 				signalException(MemoryFault);
+			strptr[gpr[6]] = 0;
 			//printf("strlen: %d\n", strlen(strptr));
 			printf("%s", strptr);
 			this->pc = gpr[31];
@@ -1238,6 +2259,8 @@ class EmulatedCPU
 		void hooked_libc_malloc(uint32_t opcode)
 		{
 			gpr[2] = (uint32_t)this->memUnit->MMUHeap.allocMem(gpr[4], beQuietFlag);
+			if(!memUnit->checkLimits())
+				signalException(ResourceFault);
 			this->pc = gpr[31];
 		}
 
@@ -1264,21 +2287,13 @@ class EmulatedCPU
 			int i = 0;
 			int formatStrLen = 0;
 			int numSpecifiers = 0;
-			char *memPtr = memUnit->getEffectiveAddress(gpr[4], 4, 4, 0, beQuietFlag);
-			
-			if(memUnit->isInStack(gpr[4]))
-			{
-				for(i = 0; *memUnit->getEffectiveAddress(gpr[4]-i, 4, 4, 0, beQuietFlag) != 0;)
-				i++;
-			}
-			else
-			{
-				for(i = 0; *memUnit->getEffectiveAddress(gpr[4]+i, 4, 4, 0, beQuietFlag) != 0;)
-				i++;
-			}
+			int64_t formatLength = memUnit->strnlen(gpr[4], UINT32_MAX, beQuietFlag);
+			if(formatLength < 0)
+				signalException(MemoryFault);
+			i = formatLength;
 			char *targetFormatStr =(char *)calloc(i+1, sizeof(char));
 			
-			memUnit->readFromMMU(memPtr, gpr[4], targetFormatStr, i);
+			memUnit->copyOut(gpr[4], targetFormatStr, i, beQuietFlag);
 			targetFormatStr[i] = 0;
 
 			//Need to convert mem pointer's order in case argument is in stack
@@ -1345,11 +2360,11 @@ class EmulatedCPU
 					break;
 				case 2:
 					printNotifs(7,"processing scanf with 2 and a str of [%s]. \n", targetFormatStr);
-					scanf(targetFormatStr, memUnit->getEffectiveAddress(gpr[5], 4, 5, 0, beQuietFlag), memUnit->getEffectiveAddress(gpr[6], 4, 6, 0, beQuietFlag));
+					scanf(targetFormatStr, memUnit->getWriteAddresss(gpr[5], 4, 5), memUnit->getWriteAddresss(gpr[6], 4, 6));
 					break;
 				case 3:
 					printNotifs(7,"processing scanf with 3 and a str of [%s]. \n", targetFormatStr);
-					scanf(targetFormatStr, memUnit->getEffectiveAddress(gpr[5], 4, 5, 0, beQuietFlag), memUnit->getEffectiveAddress(gpr[6], 4, 6), memUnit->getEffectiveAddress(gpr[7], 4, 7, 0, beQuietFlag));
+					scanf(targetFormatStr, memUnit->getWriteAddresss(gpr[5], 4, 5), memUnit->getWriteAddresss(gpr[6], 4, 6), memUnit->getWriteAddresss(gpr[7], 4, 7));
 					break;
 			
 				default:
@@ -1372,7 +2387,10 @@ class EmulatedCPU
 			}
 			char *writePtr = memUnit->getEffectiveAddress(gpr[5], 4, 5);
 			char *test = (char *)calloc(4, sizeof(char));
-			memUnit->writeToMMU(writePtr, gpr[5], scanToken, numBytes);
+			// scanf filled in a little endian host int, the guest reads it big endian
+			char *guestToken = (char *)calloc(numBytes, sizeof(char));
+			std::reverse_copy(scanToken, scanToken + numBytes, guestToken);
+			memUnit->writeToMMU(writePtr, gpr[5], guestToken, numBytes);
 			memUnit->readFromMMU(writePtr, gpr[5], test, 4);
 			printNotifs(7, "value from scanf: [%d]\n", *((uint32_t *)scanToken));
 			
@@ -1385,23 +2403,16 @@ class EmulatedCPU
 		{//4,5
 			//Only set for stream of stdout. Avoids formatted print for consistency.
 			int length = gpr[5];
-			char *buffer = memUnit->getEffectiveAddress(gpr[4], length, 0, 0, beQuietFlag);
-			if(buffer == NULL | !memUnit->isInMemory(gpr[4] + length))
+			char *buffer = (char *)calloc(length, sizeof(char));
+			if(!memUnit->copyOut(gpr[4], buffer, length, beQuietFlag) | !memUnit->isInMemory(gpr[4] + length))
 			{
 				printNotifs(2, "Bad length or pointer in fwrite\n");
 				signalException(MemoryFault);
 			}
 			
 			
-			int i=0;
-			while(i<length)
-			{
-				putc(buffer[i], stdout);
-				if(memUnit->isInStack(gpr[4]))
-					i--;
-				else
-					i++;
-			}
+			fwrite(buffer, sizeof(char), length, stdout);
+			free(buffer);
 				
 
 
@@ -1434,17 +2445,18 @@ class EmulatedCPU
 			if(fsize < 10000)
 			{
 				//printf("the pointer is 0x%x\n", gpr[4]);
-				char *buf = memUnit->getEffectiveAddress(gpr[4], 9999, 4, 0, beQuietFlag);
-				if(buf == NULL)
-				{
-					generallyPause();
-				}
+				char *buf = (char *)calloc(fsize + 1, sizeof(char));
 			    fread(buf, fsize, 1, ifp);
 			    fclose(ifp);
 			    
 			    buf[fsize] = 0;
+				if(!memUnit->copyIn(gpr[4], buf, fsize + 1))
+				{
+					generallyPause();
+				}
 			    
 			    printf("%s", buf);
+			    free(buf);
 			    printf("ending my_read\n\n\n\n\n");
 			    
 			}
@@ -1459,11 +2471,7 @@ class EmulatedCPU
 			gpr[2] = fsize;
 			gpr[3] = fsize;
 			uint32_t vAddr = 24 + gpr[30];
-			char *bytes = memUnit->getWriteAddresss(vAddr, 4, 0);
-			bytes[0] = (gpr[28] >> 24) & 0xff;
-			bytes[-1] = (gpr[28] >> 16) & 0xff;
-			bytes[-2] = (gpr[28] >> 8) & 0xff; 
-			bytes[-3] = gpr[28] & 0xff;
+			memUnit->store32(vAddr, gpr[28]);
 
 
 			// jump to ra
@@ -1472,7 +2480,13 @@ class EmulatedCPU
 
 		void hooked_my_write(uint32_t opcode)
 		{
-			printf("%s\n", memUnit->getEffectiveAddress(gpr[4], 1, 4, 0, beQuietFlag));
+			int64_t length = memUnit->strnlen(gpr[4], UINT32_MAX, beQuietFlag);
+			if(length < 0)
+				signalException(MemoryFault);
+			char *str = (char *)calloc(length + 1, sizeof(char));
+			memUnit->copyOut(gpr[4], str, length, beQuietFlag);
+			printf("%s\n", str);
+			free(str);
 			// jump to ra
 			this->pc = gpr[31];
 		}
@@ -1485,7 +2499,7 @@ class EmulatedCPU
 
 		// This is the ADD function. Opcode of 0b000000 and ALU code of 0b100 000
 		// TODO: Test with negative values.
-		void add(uint32_t opcode)
+		void add(Operands op)
 		{
 
 			if(mipsTarget < 1)
@@ -1495,20 +2509,20 @@ class EmulatedCPU
 
 			if(debugPrint)
 			{
-				printNotifs(7,"ADD %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7,"ADD %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] + gpr[rt];
+			uint64_t temp = gpr[op.rs] + gpr[op.rt];
 			uint64_t flag = BIT32;
 
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rd] = temp;
+			gpr[op.rd] = temp;
 
 		}
-		void addi(uint32_t opcode)
+		void addi(Operands op)
 		{
 
 			if (mipsTarget < 1)
@@ -1517,24 +2531,24 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7,"ADDI %s, %s, %d\n", getName(rs).c_str(), getName(rt).c_str(), signedImmediate);
+				printNotifs(7,"ADDI %s, %s, %d\n", getName(op.rs).c_str(), getName(op.rt).c_str(), op.signedImmediate);
 			}
 			
 			//this->signExtend(&immediate, 16, 32);
 
-			uint64_t temp = gpr[rs] + signedImmediate;
+			uint64_t temp = gpr[op.rs] + op.signedImmediate;
 
 			// Check for an overflow
 			uint64_t flag = is64bit ? BIT64 : BIT32;
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rt] = temp;
+			gpr[op.rt] = temp;
 
 		}
-		void addiu(uint32_t opcode)
+		void addiu(Operands op)
 		{
 
 			if (mipsTarget < 1)
@@ -1544,17 +2558,15 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7,"ADDIU %s, %s, %x\n", getName(rt).c_str(), getName(rs).c_str(), immediate);
+				printNotifs(7,"ADDIU %s, %s, %x\n", getName(op.rt).c_str(), getName(op.rs).c_str(), op.immediate);
 			}
 
 			//this->signExtend(&immediate, 16, 32);
-			int64_t temp = gpr[rs] + signedImmediate;
-			if (!is64bit)
-				temp &= 0xffffffff;
-			gpr[rt] = temp;
+			int64_t temp = gpr[op.rs] + op.signedImmediate;
+			gpr[op.rt] = temp;
 
 		}
-		void addu(uint32_t opcode)
+		void addu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1563,14 +2575,12 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7,"ADDU %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7,"ADDU %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] + gpr[rt];
-			if (!is64bit)
-				temp &= 0xffffffff;
-			gpr[rd] = temp;
+			uint64_t temp = gpr[op.rs] + gpr[op.rt];
+			gpr[op.rd] = temp;
 		}
-		void andop(uint32_t opcode)
+		void andop(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1579,11 +2589,11 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "AND %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "AND %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			gpr[rd] = gpr[rs] & gpr[rt];
+			gpr[op.rd] = gpr[op.rs] & gpr[op.rt];
 		}
-		void andi(uint32_t instruction)
+		void andi(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1592,12 +2602,12 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "ANDI %s, %s, %x\n", getName(rt).c_str(), getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "ANDI %s, %s, %x\n", getName(op.rt).c_str(), getName(op.rs).c_str(), op.signedImmediate);
 			}
-			gpr[rt] = gpr[rs] & immediate;
+			gpr[op.rt] = gpr[op.rs] & op.immediate;
 		}
 		
-		void beq(uint32_t instruction)
+		void beq(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1606,7 +2616,7 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BEQ %s, %s, %x\n", getName(rs).c_str(), getName(rt).c_str(), (instruction & 0xFFFF));
+				printNotifs(7, "BEQ %s, %s, %x\n", getName(op.rs).c_str(), getName(op.rt).c_str(), (op.instruction & 0xFFFF));
 			}
 			// Control branches are going to take a model of instruction memory first.
 			// Rose, I removed your "kekwuw". That is not appropriate. I'll be docking your pay!
@@ -1614,18 +2624,18 @@ class EmulatedCPU
 			// Also you don't pay me.
 
 			//cast to 32 bits  for auto sigm extend and space fpr shifting
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
 			
-			if (gpr[rs] == gpr[rt])
+			if (gpr[op.rs] == gpr[op.rt])
 			{
 				// If the two registers equal, we set the pc to increment after an instruction.
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void beql(uint32_t instruction)
+		void beql(Operands op)
 		{
 			// For this, simply execute the next instruction with the EmulatedCPU and the target address.
 			// Then we do the branch.
@@ -1638,15 +2648,15 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BEQL %s, %s, %x\n", getName(rs).c_str(), getName(rt).c_str(), signedImmediate);
+				printNotifs(7, "BEQL %s, %s, %x\n", getName(op.rs).c_str(), getName(op.rt).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 
 			
-			if (gpr[rs] == gpr[rt])
+			if (gpr[op.rs] == gpr[op.rt])
 			{
 				// If the two registers equal, we increment PC by the offset.
 				delaySlot = true;
@@ -1659,7 +2669,7 @@ class EmulatedCPU
 
 
 		}
-		void bgez(uint32_t instruction)
+		void bgez(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1668,12 +2678,12 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BGEZ %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BGEZ %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 			
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
-			int64_t lhs = (int) gpr[rs];
+			int64_t lhs = (int) gpr[op.rs];
 
 			delaySlot = true;
 
@@ -1684,7 +2694,7 @@ class EmulatedCPU
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bgezal(uint32_t instruction)
+		void bgezal(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1693,13 +2703,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BGEZAL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BGEZAL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			delaySlot = true;
 
@@ -1712,7 +2722,7 @@ class EmulatedCPU
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bgezall (uint32_t instruction)
+		void bgezall (Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1721,13 +2731,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BGEZALL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BGEZALL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			// Set return address equal to the value.
 			gpr[31] = pc + 8;
@@ -1743,7 +2753,7 @@ class EmulatedCPU
 				instructionNullify = true;
 			}
 		}
-		void bgezl(uint32_t instruction)
+		void bgezl(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -1752,13 +2762,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "bgezl %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "bgezl %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 			
 			if (lhs >= 0)
 			{
@@ -1772,7 +2782,7 @@ class EmulatedCPU
 			}
 
 		}
-		void bgtz(uint32_t instruction)
+		void bgtz(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1781,23 +2791,23 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BGTZ %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BGTZ %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
-			if (gpr[rs] >= 0)
+			if (gpr[op.rs] >= 0)
 			{
 				// If the two registers equal, we increment PC by the offset.
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bgtzl(uint32_t instruction)
+		void bgtzl(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -1806,13 +2816,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BGTZL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BGTZL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 			
 			if (lhs >= 0)
 			{
@@ -1825,7 +2835,7 @@ class EmulatedCPU
 				instructionNullify = true;
 			}
 		}
-		void blez(uint32_t instruction)
+		void blez(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1834,14 +2844,14 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLEZ %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLEZ %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
-			int lhs = gpr[rs];
+			int lhs = gpr[op.rs];
 
 			if (lhs <= 0)
 			{
@@ -1849,7 +2859,7 @@ class EmulatedCPU
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void blezl(uint32_t instruction)
+		void blezl(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -1858,13 +2868,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLEZL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLEZL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			if (lhs <= 0)
 			{
@@ -1878,7 +2888,7 @@ class EmulatedCPU
 				instructionNullify = true;
 			}
 		}
-		void bltz(uint32_t instruction)
+		void bltz(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1887,14 +2897,14 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLTZ %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLTZ %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			if (lhs < 0)
 			{
@@ -1902,7 +2912,7 @@ class EmulatedCPU
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bltzal(uint32_t instruction)
+		void bltzal(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1911,14 +2921,14 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLTZAL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLTZAL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			gpr[31] = pc + 8;
 			if (lhs < 0)
@@ -1927,7 +2937,7 @@ class EmulatedCPU
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bltzall(uint32_t instruction)
+		void bltzall(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -1936,14 +2946,14 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLTZALL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLTZALL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			gpr[31] = pc + 8;
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 			if (lhs < 0)
 			{
 				// If the two registers equal, we increment PC by the offset.
@@ -1955,7 +2965,7 @@ class EmulatedCPU
 				instructionNullify = true;
 			}
 		}
-		void bltzl(uint32_t instruction)
+		void bltzl(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -1964,12 +2974,12 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BLTZL %s, %x\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "BLTZL %s, %x\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
-			int64_t lhs = gpr[rs];
+			int64_t lhs = gpr[op.rs];
 
 			if (lhs < 0)
 			{
@@ -1982,7 +2992,7 @@ class EmulatedCPU
 				instructionNullify = true;
 			}
 		}
-		void bne(uint32_t instruction)
+		void bne(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -1991,21 +3001,21 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "BNE %s, %s, %x\n", getName(rs).c_str(), getName(rt).c_str(), (instruction & 0xFFFF));
+				printNotifs(7, "BNE %s, %s, %x\n", getName(op.rs).c_str(), getName(op.rt).c_str(), (op.instruction & 0xFFFF));
 			}
 
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 
 			delaySlot = true;
 			
-			if (gpr[rs] != gpr[rt])
+			if (gpr[op.rs] != gpr[op.rt])
 			{
 				// If the two registers equal, we increment PC by the offset.
 				tgt_offset = extendedImmediate;
 			}
 		}
-		void bnel(uint32_t instruction)
+		void bnel(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -2014,13 +3024,13 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "bne %s, %s, %x\n", getName(rs).c_str(), getName(rt).c_str(), (instruction & 0xFFFF));
+				printNotifs(7, "bne %s, %s, %x\n", getName(op.rs).c_str(), getName(op.rt).c_str(), (op.instruction & 0xFFFF));
 			}
 			
-			int32_t extendedImmediate = signedImmediate;
+			int32_t extendedImmediate = op.signedImmediate;
 			extendedImmediate <<= 2;
 			
-			if (gpr[rs] != gpr[rt])
+			if (gpr[op.rs] != gpr[op.rt])
 			{
 				// If the two registers equal, we increment PC by the offset.
 				delaySlot = true;
@@ -2032,20 +3042,20 @@ class EmulatedCPU
 			}
 		}
 		// break_ because break is a C++ reserved word
-		void break_(uint32_t instruction)
+		void break_(Operands op)
 		{
 			printf("Called Break!\n");
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// Co Processor Operation (should be unimplemented I think)
-		void copz(uint32_t instruction)
+		void copz(Operands op)
 		{
 			printf("Called COPz!\n");
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS III
 		// Assigned to Rose.
-		void dadd(uint32_t instruction)
+		void dadd(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2054,22 +3064,22 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "DADD %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DADD %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] + gpr[rt];
+			uint64_t temp = gpr[op.rs] + gpr[op.rt];
 			uint64_t flag = BIT64;
 
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rd] = temp;
+			gpr[op.rd] = temp;
 			return;
 		}
 
 		// MIPS III
-		void daddi(uint32_t instruction)
+		void daddi(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2077,25 +3087,25 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DADDI %s, %s, %d\n", getName(rs).c_str(), getName(rt).c_str(), signedImmediate);
+				printNotifs(7, "DADDI %s, %s, %d\n", getName(op.rs).c_str(), getName(op.rt).c_str(), op.signedImmediate);
 			}
 
 			//this->signExtend(&immediate, 16, 32);
 
-			uint64_t temp = gpr[rs] + signedImmediate;
+			uint64_t temp = gpr[op.rs] + op.signedImmediate;
 
 			// Check for an overflow
 			uint64_t flag = BIT64;
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rt] = temp;
+			gpr[op.rt] = temp;
 		}
 
 		//MIPS III
-		void daddiu(uint32_t opcode)
+		void daddiu(Operands op)
 		{
 
 			if (mipsTarget < 3)
@@ -2105,17 +3115,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "DADDIU %s, %s, %dx\n", getName(rs).c_str(), getName(rt).c_str(), immediate);
+				printNotifs(7, "DADDIU %s, %s, %dx\n", getName(op.rs).c_str(), getName(op.rt).c_str(), op.immediate);
 			}
 
 			//this->signExtend(&immediate, 16, 32);
-			uint64_t temp = gpr[rs] + immediate;
-			gpr[rt] = temp;
+			uint64_t temp = gpr[op.rs] + op.immediate;
+			gpr[op.rt] = temp;
 
 		}
 
 		//MIPS III
-		void daddu(uint32_t opcode)
+		void daddu(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2124,15 +3134,15 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "DADDU %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DADDU %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] + gpr[rt];
+			uint64_t temp = gpr[op.rs] + gpr[op.rt];
 
-			gpr[rd] = temp;
+			gpr[op.rd] = temp;
 		}
 
 		//MIPS III
-		void ddiv(uint32_t instruction)
+		void ddiv(Operands op)
 		{
 			
 			if (mipsTarget < 3)
@@ -2141,21 +3151,21 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DDIV %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DDIV %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (rt == 0)
+			if (op.rt == 0)
 			{
 				return;
 			}
 
-			LO = (int64_t) gpr[rs] / (int64_t)gpr[rt];
-			HI = rs % rt;
+			LO = (int64_t) gpr[op.rs] / (int64_t)gpr[op.rt];
+			HI = op.rs % op.rt;
 			return;
 		}
 
 		//MIPS III
-		void ddivu(uint32_t instruction)
+		void ddivu(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2163,22 +3173,22 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DDIVU %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DDIVU %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (rt == 0)
+			if (op.rt == 0)
 			{
 				return;
 			}
 
-			LO = gpr[rs] / gpr[rt];
-			HI = gpr[rs] % gpr[rt];
+			LO = gpr[op.rs] / gpr[op.rt];
+			HI = gpr[op.rs] % gpr[op.rt];
 			return;
 		}
 
 
 		// MIPS 1
-		void div(uint32_t instruction)
+		void div(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2186,16 +3196,16 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DIV %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DIV %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (rt == 0)
+			if (op.rt == 0)
 			{
 				return;
 			}
-			int64_t q = ((int64_t)gpr[rs] / (int64_t)gpr[rt]);
-			int64_t r = gpr[rs] % gpr[rt];
-			if (is64bit)
+			int64_t q = ((int64_t)gpr[op.rs] / (int64_t)gpr[op.rt]);
+			int64_t r = gpr[op.rs] % gpr[op.rt];
+			if constexpr (is64bit)
 			{
 				if((q & BIT32) > 0)
 					q |= (((uint64_t)0xffffffff) << 32);
@@ -2208,7 +3218,7 @@ class EmulatedCPU
 		}
 
 		//MIPS I
-		void divu(uint32_t instruction)
+		void divu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2216,16 +3226,16 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DIVU %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DIVU %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (rt == 0)
+			if (op.rt == 0)
 			{
 				return;
 			}
-			uint64_t q = gpr[rs] / gpr[rt];
-			uint64_t r = gpr[rs] % gpr[rt];
-			if (is64bit)
+			uint64_t q = gpr[op.rs] / gpr[op.rt];
+			uint64_t r = gpr[op.rs] % gpr[op.rt];
+			if constexpr (is64bit)
 			{
 				if ((q & BIT32) > 0)
 					q |= (((uint64_t)0xffffffff) << 32);
@@ -2238,7 +3248,7 @@ class EmulatedCPU
 			return;
 		}
 		// MIPS III
-		void dmult(uint32_t instruction)
+		void dmult(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2246,10 +3256,10 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DMULT %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DMULT %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			int64_t M = gpr[rs];
-			uint64_t Q = gpr[rt];
+			int64_t M = gpr[op.rs];
+			uint64_t Q = gpr[op.rt];
 			int count = 64;
 			int64_t A = 0;
 			bool Qinv = 0;
@@ -2281,7 +3291,7 @@ class EmulatedCPU
 		}
 
 		//MIPS III
-		void dmultu(uint32_t instruction)
+		void dmultu(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2289,32 +3299,34 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DMULT %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DMULT %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			int64_t M = gpr[rs];
-			uint64_t Q = gpr[rt];
+			int64_t M = gpr[op.rs];
+			uint64_t Q = gpr[op.rt];
 			int count = 64;
-			int64_t A = 0;
-			uint64_t ptr = 0;
-			HI = 0;
-			LO = 0;
+			// Accumulate at 64 bits regardless of the register width; shifting a
+			// 32 bit Word by 63 is undefined.
+			uint64_t hi = 0;
+			uint64_t lo = 0;
 
 			while (count > 0)
 			{
 				if (Q & 1)
 				{
-					HI += M;
+					hi += M;
 				}
 				Q >>= 1;
-				LO >>= 1;
-				ptr = (HI & 1) << 63;
-				LO |= ptr;
-				HI >>= 1;
+				lo >>= 1;
+				lo |= (hi & 1) << 63;
+				hi >>= 1;
+				count--;
 			}
+			HI = hi;
+			LO = lo;
 		}
 
 		//MIPS III
-		void dsll(uint32_t instruction)
+		void dsll(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2322,14 +3334,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSLL %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSLL %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 			
-			gpr[rd] = gpr[rt] << sa;
+			gpr[op.rd] = gpr[op.rt] << op.sa;
 		}
 
 		//MIPS III
-		void dsll32(uint32_t instruction)
+		void dsll32(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2337,14 +3349,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSLL32 %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSLL32 %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			gpr[rd] = gpr[rt] << (sa + 32);
+			gpr[op.rd] = (uint64_t)gpr[op.rt] << (op.sa + 32);
 		}
 
 		//MIPS III
-		void dsllv(uint32_t instruction)
+		void dsllv(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2352,14 +3364,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSLLV %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "DSLLV %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			gpr[rd] = gpr[rt] << (gpr[rs] & 0x3f);
+			gpr[op.rd] = (uint64_t)gpr[op.rt] << (gpr[op.rs] & 0x3f);
 		}
 		
 		//MIPS III
-		void dsra(uint32_t instruction)
+		void dsra(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2367,15 +3379,15 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRA %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSRA %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			int64_t hold = gpr[rt];
-			gpr[rd] = (uint64_t) (hold >> sa);
+			int64_t hold = gpr[op.rt];
+			gpr[op.rd] = (uint64_t) (hold >> op.sa);
 		}
 
 		//MIPS III
-		void dsra32(uint32_t instruction)
+		void dsra32(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2383,15 +3395,15 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRA32 %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSRA32 %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			int64_t hold = gpr[rt];
-			gpr[rd] = (uint64_t)(hold >> (sa+32));
+			int64_t hold = gpr[op.rt];
+			gpr[op.rd] = (uint64_t)(hold >> (op.sa+32));
 		}
 
 		//MIPS III
-		void dsrav(uint32_t instruction)
+		void dsrav(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2399,15 +3411,15 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRA %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "DSRA %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			int64_t hold = gpr[rt];
-			gpr[rd] = (uint64_t)(hold >> (gpr[rs] & 0x3f));
+			int64_t hold = gpr[op.rt];
+			gpr[op.rd] = (uint64_t)(hold >> (gpr[op.rs] & 0x3f));
 		}
 
 		//MIPS III
-		void dsrl(uint32_t instruction)
+		void dsrl(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2415,14 +3427,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRL %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSRL %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			gpr[rd] = gpr[rt] >> sa;
+			gpr[op.rd] = gpr[op.rt] >> op.sa;
 		}
 
 		//MIPS III
-		void dsrl32(uint32_t instruction)
+		void dsrl32(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2430,14 +3442,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRL32 %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "DSRL32 %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			gpr[rd] = gpr[rt] >> (sa+32);
+			gpr[op.rd] = (uint64_t)gpr[op.rt] >> (op.sa+32);
 		}
 
 		//MIPS III
-		void dsrlv(uint32_t instruction)
+		void dsrlv(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2445,14 +3457,14 @@ class EmulatedCPU
 			}
 			if (debugPrint)
 			{
-				printNotifs(7, "DSRLV %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "DSRLV %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			gpr[rd] = gpr[rt] >> (gpr[rs] & 0x3f);
+			gpr[op.rd] = (uint64_t)gpr[op.rt] >> (gpr[op.rs] & 0x3f);
 		}
 
 		//MIPS III
-		void dsub(uint32_t instruction)
+		void dsub(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2461,22 +3473,22 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "DSUB %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DSUB %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] - gpr[rt];
+			uint64_t temp = gpr[op.rs] - gpr[op.rt];
 			uint64_t flag = BIT64;
 
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rd] = temp;
+			gpr[op.rd] = temp;
 			return;
 		}
 
 		//MIPS III
-		void dsubu(uint32_t instruction)
+		void dsubu(Operands op)
 		{
 			if (mipsTarget < 3)
 			{
@@ -2485,16 +3497,16 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "DSUBU %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "DSUBU %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			gpr[rd] = gpr[rs] - gpr[rt];
+			gpr[op.rd] = gpr[op.rs] - gpr[op.rt];
 		}
 		// Jumps
 		//MIPS I
-		void j(uint32_t instruction)
+		void j(Operands op)
 		{
-			uint64_t instr_index = (instruction & 0x3fffff) << 2;
+			uint64_t instr_index = (op.instruction & 0x3fffff) << 2;
 
 			if (mipsTarget < 1)
 			{
@@ -2506,7 +3518,7 @@ class EmulatedCPU
 				printNotifs(7,"J %lx\n", instr_index);
 			}
 
-			runInstruction(getNextInstruction());
+			runDecoded(getDecoded(pc + 4));
 			
 			uint64_t mask = is64bit ? 0xfffffffff0000000 : 0xf0000000;
 
@@ -2514,10 +3526,10 @@ class EmulatedCPU
 		}
 
 		//MIPS I
-		void jal(uint32_t instruction)
+		void jal(Operands op)
 		{
 
-			uint64_t instr_index = (instruction & 0x3fffff) << 2;
+			uint64_t instr_index = (op.instruction & 0x3fffff) << 2;
 
 			if (mipsTarget < 1)
 			{
@@ -2529,7 +3541,7 @@ class EmulatedCPU
 				printNotifs(7, "JAL %lx\n", instr_index);
 			}
 
-			runInstruction(getNextInstruction());
+			runDecoded(getDecoded(pc + 4));
 
 			gpr[31] = pc + 8;
 
@@ -2539,7 +3551,7 @@ class EmulatedCPU
 		}
 
 		//MIPS I
-		void jalr(uint32_t instruction)
+		void jalr(Operands op)
 		{
 
 			if (mipsTarget < 1)
@@ -2553,15 +3565,15 @@ class EmulatedCPU
 				printNotifs(7, "JALR ");
 				if(globalLogLevel <= 7 && !beQuietFlag)
 				{
-					if (rd != 31)
-						printf("%s, ", getName(rd).c_str());
-					printf("%s\n", getName(rs).c_str());
+					if (op.rd != 31)
+						printf("%s, ", getName(op.rd).c_str());
+					printf("%s\n", getName(op.rs).c_str());
 				}
 			}
-			uint64_t temp = gpr[rs];
-			gpr[rd] = pc + 8;
+			uint64_t temp = gpr[op.rs];
+			gpr[op.rd] = pc + 8;
 
-			runInstruction(getNextInstruction());
+			runDecoded(getDecoded(pc + 4));
 			
 			// TODO:
 			// Before we do, let's verify that we're not about to jump into the GOT
@@ -2580,7 +3592,7 @@ class EmulatedCPU
 		}
 
 		//MIPS I
-		void jr(uint32_t instruction)
+		void jr(Operands op)
 		{
 
 			if (mipsTarget < 1)
@@ -2591,12 +3603,12 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "JR %s\n", getName(rs).c_str());
+				printNotifs(7, "JR %s\n", getName(op.rs).c_str());
 			}
 			
-			uint64_t temp = gpr[rs];
+			uint64_t temp = gpr[op.rs];
 
-			if(pc >= startOfMain && pc < endOfMain && rs == 31)
+			if(pc >= startOfMain && pc < endOfMain && op.rs == 31)
 			{
 				endOfEmulation = clock();
 				if (timer == true)
@@ -2611,13 +3623,13 @@ class EmulatedCPU
 				//raise(SIGKILL);
 			}
 
-			runInstruction(getNextInstruction());
+			runDecoded(getDecoded(pc + 4));
 
 			
 
 			pc = temp - 4;
 		}
-		void lb(uint32_t instruction)
+		void lb(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2626,13 +3638,18 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LB %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "LB %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			char *byte = memUnit->getEffectiveAddress(vAddr, 1, rs, gpr[rs], beQuietFlag);
-			gpr[rt] = (int64_t)(*byte);
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			uint8_t byte;
+			if(!memUnit->load8(vAddr, byte, beQuietFlag))
+			{
+				printNotifs(7, "bytes==NULL\n");
+				signalException(MemoryFault);
+			}
+			gpr[op.rt] = (int64_t)(int8_t)byte;
 		}
-		void lbu(uint32_t instruction)
+		void lbu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2641,42 +3658,41 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LBU %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "LBU %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			char *byte = memUnit->getEffectiveAddress(vAddr, 1, rs, gpr[rs], beQuietFlag);
-			if(byte == NULL)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			uint8_t byte;
+			if(!memUnit->load8(vAddr, byte, beQuietFlag))
 			{
-				BNShutdown();
-				raise(SIGKILL);
+				printNotifs(7, "bytes==NULL\n");
+				signalException(MemoryFault);
 			}
-			gpr[rt] = (uint64_t)(*byte);
+			gpr[op.rt] = byte;
 
 		}
 		// MIPS 3
-		void LD(uint32_t instruction)
+		void LD(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 2, likely going to be unimplemented
-		void LDCz(uint32_t instruction)
+		void LDCz(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 3
-		void LDL(uint32_t instruction)
+		void LDL(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
-		void LDR(uint32_t instruction)
+		void LDR(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 1
-		void lh(uint32_t instruction)
+		void lh(Operands op)
 		{
 			bool BigEndian = true;
-			is64bit = false;
 			if (mipsTarget < 1)
 			{
 				printNotifs(4, "Invalid mips target for LW\n");
@@ -2684,59 +3700,30 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LW %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "LW %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
 			
 		
-			if (is64bit)
-			{
-
-			}
-			else
+			int32_t offset = op.immediate;
+			if(op.immediate & 1 > 0)
 			{
-				int32_t offset = immediate;
-				if(immediate & 1 > 0)
-				{
-					printNotifs(7, "what?\n");
-					signalException(MemoryFault);
-				}
-					
-				
-				//Destination address
-				uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-				//Get bytes in-order from mmu
-				//memUnit->printSections();
-				char *bytes = memUnit->getEffectiveAddress(vAddr, 4, rs, gpr[rs], beQuietFlag);
-				if(bytes == NULL)
-				{
-					printNotifs(7, "bytes==NULL\n");
-					signalException(MemoryFault);
-				}
-				
-				fflush(stdout);
-				//change their order depending on endianness??
-
-				//Emulated stack pointer is backwards. have to reverse it for writes
-				if(memUnit->isInStack(vAddr))
-				{
-					//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[-1], bytes[-2], bytes[-3], 
-					//																	bytes[0], bytes[-1], bytes[-2], bytes[-3]);
-					gpr[rt] = 0;
-					gpr[rt] |= ((uint64_t)(bytes[-1] & 0xff)) << 0;
-					gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 8;
-				}
-				else
-				{
-					//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[1], bytes[2], bytes[3], 
-					//																	bytes[0], bytes[1], bytes[2], bytes[3]);
-					gpr[rt] = 0;
-					gpr[rt] |= ((uint64_t)(bytes[1] & 0xff)) ;
-					gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 8;
-				}
+				printNotifs(7, "what?\n");
+				signalException(MemoryFault);
 			}
+				
+			
+			//Destination address
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			uint16_t half;
+			if(!memUnit->load16(vAddr, half, beQuietFlag))
+			{
+				printNotifs(7, "bytes==NULL\n");
+				signalException(MemoryFault);
+			}
+			gpr[op.rt] = (int64_t)(int16_t)half;
 		}
-		void lhu(uint32_t instruction)
+		void lhu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2745,44 +3732,29 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LHU %s, %d(%s)\n", getName(rt).c_str(), immediate, getName(rs).c_str());
+				printNotifs(7, "LHU %s, %d(%s)\n", getName(op.rt).c_str(), op.immediate, getName(op.rs).c_str());
 			}
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			char *bytes = memUnit->getEffectiveAddress(vAddr, 2, rs, gpr[rs], beQuietFlag);
-			if(bytes == NULL)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			uint16_t half;
+			if(!memUnit->load16(vAddr, half, beQuietFlag))
 			{
 				printNotifs(7, "bytes==NULL\n");
 				signalException(MemoryFault);
 			}
-			if(memUnit->isInStack(vAddr))
-			{
-				//? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[-1], bytes[-2], bytes[-3], 
-				//																	bytes[0], bytes[-1], bytes[-2], bytes[-3]);
-				gpr[rt] = 0;
-				gpr[rt] |= ((uint64_t)(bytes[-1] & 0xff));
-				gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 8;
-			}
-			else
-			{
-				//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[1], bytes[2], bytes[3], 
-				//																	bytes[0], bytes[1], bytes[2], bytes[3]);
-				gpr[rt] = 0;
-				gpr[rt] |= ((uint64_t)(bytes[1] & 0xff));
-				gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 8;
-			}
+			gpr[op.rt] = half;
 		}
 		// MIPS 2
-		void LL(uint32_t instruction)
+		void LL(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 3
-		void LLD(uint32_t instruction)
+		void LLD(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 1
-		void lui(uint32_t instruction)
+		void lui(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2792,17 +3764,16 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7,"LUI %s, %x\n", getName(rt).c_str(), immediate);
+				printNotifs(7,"LUI %s, %x\n", getName(op.rt).c_str(), op.immediate);
 			}
-			int32_t hold = (int32_t) immediate;
-			gpr[rt] = hold << 16;
+			int32_t hold = (int32_t) op.immediate;
+			gpr[op.rt] = hold << 16;
 		}
 
 		//MIPS I
-		void lw(uint32_t instruction)
+		void lw(Operands op)
 		{
 			bool BigEndian = true;
-			is64bit = false;
 			if (mipsTarget < 1)
 			{
 				printNotifs(4, "Invalid mips target for LW\n");
@@ -2810,87 +3781,37 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LW %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "LW %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
 			
 		
-			if (is64bit)
+			int32_t offset = op.immediate;
+			if(op.immediate & 3 > 0)
 			{
-
+				printNotifs(7, "what?\n");
+				signalException(MemoryFault);
 			}
-			else
-			{
-				int32_t offset = immediate;
-				if(immediate & 3 > 0)
-				{
-					printNotifs(7, "what?\n");
-					signalException(MemoryFault);
-				}
-					
-				
-				//Destination address
-				uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-				//Get bytes in-order from mmu
-				//memUnit->printSections();
-				char *bytes = memUnit->getEffectiveAddress(vAddr, 4, rs, gpr[rs], beQuietFlag);
-				if(bytes == NULL)
-				{
-					printNotifs(7, "bytes==NULL\n");
-					signalException(MemoryFault);
-				}
 				
-				fflush(stdout);
-				//change their order depending on endianness??
-
-				//Emulated stack pointer is backwards. have to reverse it for writes
-				if(memUnit->isInStack(vAddr))
-				{
-					//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[-1], bytes[-2], bytes[-3], 
-					//																	bytes[0], bytes[-1], bytes[-2], bytes[-3]);
-					gpr[rt] = 0;
-					gpr[rt] |= (uint64_t)(bytes[-3] & 0xff);
-					gpr[rt] |= ((uint64_t)(bytes[-2] & 0xff)) << 8;
-					gpr[rt] |= ((uint64_t)(bytes[-1] & 0xff)) << 16;
-					gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 24;
-				}
-				else
-				{
-					//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[1], bytes[2], bytes[3], 
-					//																	bytes[0], bytes[1], bytes[2], bytes[3]);
-					gpr[rt] = 0;
-					gpr[rt] |= (uint64_t)(bytes[3] & 0xff);
-					gpr[rt] |= ((uint64_t)(bytes[2] & 0xff)) << 8;
-					gpr[rt] |= ((uint64_t)(bytes[1] & 0xff)) << 16;
-					gpr[rt] |= ((uint64_t)(bytes[0] & 0xff)) << 24;
-				}
-				
-				//printf("%lx\n", gpr[rt]);
-				/*if(BigEndian)
-				{
-					for(int i=0;i<4;i++)
-					{
-						gpr[rt] &= bytes[i] << i*8;
-					}
-				}
-				else
-				{
-					for(int i=0;i<4;i++)
-					{
-						gpr[rt] &= bytes[3-i] << i*8;
-					}
-				}*/
+			
+			//Destination address
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			uint32_t word;
+			if(!memUnit->load32(vAddr, word, beQuietFlag))
+			{
+				printNotifs(7, "bytes==NULL\n");
+				signalException(MemoryFault);
 			}
-
+			gpr[op.rt] = word;
 		}
 		// Likely to be unimplemented
-		void lwcz(uint32_t instruction)
+		void lwcz(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		
 		//load word left
-		void lwl(uint32_t instruction)
+		void lwl(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2899,63 +3820,38 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LWL %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "LWL %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
-			bool BigEndian = true;
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			uint32_t lowMask = 0x00ffffff;
-			int32_t highMask = 0;
-			int i = vAddr & 3, j = 24, k = 0;
-			char *bytes = memUnit->getEffectiveAddress(vAddr, 4-i, rs, 0, beQuietFlag);
-			if(bytes == NULL)
-				generallyPause();
-				
-			//printf("%d, %d, %d\n", i, vAddr);
-
-			if(BigEndian)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			int i = vAddr & 3;
+			uint32_t word;
+			// The bytes from vAddr to the end of its word fill rt from the top
+			if(i == 0)
 			{
-				
-				if(memUnit->isInStack(vAddr))
-				{
-					while(i <= 3)
-					{
-						//mask only zeros out the byte being written to, preserving the bytes that dont get written to
-						highMask = (~lowMask) << 8;
-						gpr[rt] &= lowMask | highMask;
-						gpr[rt] |= (uint64_t)bytes[k] << j;
-						//bytes[k] = (gpr[rt] >> j) & 0xff;
-						i++;
-						j -= 8;
-						k--;
-						lowMask >>= 8;
-						highMask >>= 8;
-
-					}
-				}
-				else
+				if(!memUnit->load32(vAddr, word, beQuietFlag))
+					signalException(MemoryFault);
+			}
+			else
+			{
+				word = 0;
+				for(int k = 0; k < 4 - i; k++)
 				{
-					while(i <= 3)
-					{
-						highMask = (~lowMask) << 8;
-						//printf("i: %d\n", i);
-						//mask only zeros out the byte being written to, preserving the bytes that dont get written to
-						gpr[rt] &= lowMask | highMask;
-						gpr[rt] |= (uint64_t)bytes[k] << j;
-						//bytes[k] = (gpr[rt] >> j) & 0xff;
-						i++;
-						j -= 8;
-						k++;
-						lowMask >>= 8;
-						highMask >>= 8;
-					}
+					uint8_t byte;
+					if(!memUnit->load8(vAddr + k, byte, beQuietFlag))
+						signalException(MemoryFault);
+					word |= (uint32_t)byte << (24 - 8 * k);
 				}
-				if(gpr[rt] >> 31 && is64bit)
-					gpr[rt] |= (uint64_t)0xffffffff << 32;
-				
+				word |= (uint32_t)gpr[op.rt] & (0xffffffff >> (32 - 8 * i));
+			}
+			gpr[op.rt] = word;
+			if constexpr (is64bit)
+			{
+				if(gpr[op.rt] >> 31)
+					gpr[op.rt] |= (uint64_t)0xffffffff << 32;
 			}
 		}
-		void lwr(uint32_t instruction)
+		void lwr(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -2964,66 +3860,54 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "LWR %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "LWR %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
-			bool BigEndian = true;
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			uint32_t lowMask = 0xff;
-			int32_t highMask = 0xffffff00;
-
-
-			int i = vAddr & 3, j = 0, k = 0;
-			char *bytes = memUnit->getEffectiveAddress(vAddr - i, i, rs, 0, beQuietFlag);
-			if(bytes == NULL)
-				generallyPause();
-			/*if(memUnit->isInStack(vAddr))
-				bytes -= i;
-			else
-				bytes += i;*/
-
-			if(bytes == NULL)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			int i = vAddr & 3;
+			uint32_t word;
+			// The bytes from the start of vAddr's word up to vAddr fill rt from the bottom
+			if(i == 3)
 			{
-				printNotifs(2, "Bytes == null in LWR");
-				generallyPause();
+				if(!memUnit->load32(vAddr - 3, word, beQuietFlag))
+				{
+					printNotifs(2, "Bytes == null in LWR");
+					signalException(MemoryFault);
+				}
 			}
-			
-			if(BigEndian)
+			else
 			{
-					while(i >= 0)
+				word = (uint32_t)gpr[op.rt] & (0xffffffff << (8 * (i + 1)));
+				for(int k = 0; k <= i; k++)
+				{
+					uint8_t byte;
+					if(!memUnit->load8(vAddr - k, byte, beQuietFlag))
 					{
-						//printf("Heap/binary lwring\n");
-						
-						lowMask = (uint64_t)(~highMask);
-						lowMask >>= 8;
-						bytes = memUnit->getEffectiveAddress(vAddr + k, 1, rs, 0, beQuietFlag);
-						//printf("mask: %x, %x, %x\n", lowMask, highMask, lowMask | highMask);
-						gpr[rt] &= lowMask | highMask;
-						gpr[rt] |= (uint32_t)(bytes[0]) << j;
-						//printf("%x\n", gpr[rt]);
-						//printNotifs(7, "writing to %x", bytes+k);
-						//bytes[k] = (gpr[rt] >> j) & 0xff;
-						i--;
-						j += 8;
-						highMask <<= 8;
-						k--;
+						printNotifs(2, "Bytes == null in LWR");
+						signalException(MemoryFault);
 					}
-				
-				if(vAddr & 3 == 3 && gpr[rt] >> 31 == 1)
-				{
-					gpr[rt] |= (uint64_t)0xffffffff << 32;
+					word |= (uint32_t)byte << (8 * k);
 				}
 			}
-		
+			if constexpr (is64bit)
+			{
+				// A whole word is sign extended, a partial one leaves the upper half alone
+				if(i == 3)
+					gpr[op.rt] = (int64_t)(int32_t)word;
+				else
+					gpr[op.rt] = (gpr[op.rt] & ((uint64_t)0xffffffff << 32)) | word;
+			}
+			else
+				gpr[op.rt] = word;
 		}
 		// MIPS 3
-		void LWU(uint32_t instruction)
+		void LWU(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 
 		// MIPS 1
-		void mfhi(uint32_t instruction)
+		void mfhi(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3033,12 +3917,12 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MFHI %s\n", getName(rd).c_str());
+				printNotifs(7, "MFHI %s\n", getName(op.rd).c_str());
 			}
 
-			gpr[rd] = HI;
+			gpr[op.rd] = HI;
 		}
-		void mflo(uint32_t instruction)
+		void mflo(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3048,13 +3932,13 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MFLO %s\n", getName(rd).c_str());
+				printNotifs(7, "MFLO %s\n", getName(op.rd).c_str());
 			}
 
-			gpr[rd] = LO;
+			gpr[op.rd] = LO;
 		}
 		// MIPS 4
-		void MOVN(uint32_t instruction)
+		void MOVN(Operands op)
 		{
 
 			if (mipsTarget < 4)
@@ -3065,17 +3949,17 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MOVN %s, %s, %s", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "MOVN %s, %s, %s", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (gpr[rt] != 0)
+			if (gpr[op.rt] != 0)
 			{
-				gpr[rd] = gpr[rs];
+				gpr[op.rd] = gpr[op.rs];
 			}
 		}
 
 		//MIPS IV
-		void MOVZ(uint32_t instruction)
+		void MOVZ(Operands op)
 		{
 			if (mipsTarget < 4)
 			{
@@ -3085,16 +3969,16 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MOVZ %s, %s, %s", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "MOVZ %s, %s, %s", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if (gpr[rt] == 0)
+			if (gpr[op.rt] == 0)
 			{
-				gpr[rd] = gpr[rs];
+				gpr[op.rd] = gpr[op.rs];
 			}
 		}
 		// MIPS 1
-		void mthi(uint32_t instruction)
+		void mthi(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3104,14 +3988,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MTHI %s", getName(rs).c_str());
+				printNotifs(7, "MTHI %s", getName(op.rs).c_str());
 			}
 
-			HI = gpr[rs];
+			HI = gpr[op.rs];
 		}
 
 		//MIPS I
-		void mtlo(uint32_t instruction)
+		void mtlo(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3121,16 +4005,16 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MTLO %s", getName(rs).c_str());
+				printNotifs(7, "MTLO %s", getName(op.rs).c_str());
 			}
 
-			LO = gpr[rs];
+			LO = gpr[op.rs];
 		}
 
 
 
 		//MIPS I
-		void mult(uint32_t instruction)
+		void mult(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3140,18 +4024,18 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MULT %s, %s", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "MULT %s, %s", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
 			int64_t a, b, result;
 
-			a = gpr[rs];
-			b = gpr[rt];
-			if (is64bit)
+			a = gpr[op.rs];
+			b = gpr[op.rt];
+			if constexpr (is64bit)
 			{
 				//sign extensions
-				a = (gpr[rs] & BIT32) ? gpr[rs] | 0xffffffff00000000 : gpr[rs] & 0xffffffff;
-				b = (gpr[rt] & BIT32) ? gpr[rt] | 0xffffffff00000000 : gpr[rt] & 0xffffffff;
+				a = (gpr[op.rs] & BIT32) ? gpr[op.rs] | 0xffffffff00000000 : gpr[op.rs] & 0xffffffff;
+				b = (gpr[op.rt] & BIT32) ? gpr[op.rt] | 0xffffffff00000000 : gpr[op.rt] & 0xffffffff;
 
 			}
 
@@ -3163,7 +4047,7 @@ class EmulatedCPU
 		}
 
 		//MIPS I
-		void multu(uint32_t instruction)
+		void multu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3173,14 +4057,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "MULTU %s, %s", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "MULTU %s, %s", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
 			uint64_t a, b, result;
 
 			//sign extensions
-			a = gpr[rs] & 0xffffffff;
-			b = gpr[rt] & 0xffffffff;
+			a = gpr[op.rs] & 0xffffffff;
+			b = gpr[op.rt] & 0xffffffff;
 
 			//For some reason you still sign extend the result in lo and hi.
 			result = a * b;
@@ -3192,7 +4076,7 @@ class EmulatedCPU
 		}
 
 		//MIPS 32
-		void mul(uint32_t instruction)
+		void mul(Operands op)
 		{
 			if (mipsTarget < 32)
 			{
@@ -3201,16 +4085,16 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "MUL %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "MUL %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			mult(instruction);
-			gpr[rd] = LO;
+			mult(op);
+			gpr[op.rd] = LO;
 
 		}
 
 		//MIPS I
-		void nor(uint32_t instruction)
+		void nor(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3220,14 +4104,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "NOR %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "NOR %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			gpr[rd] = ~(gpr[rs] | gpr[rt]);
+			gpr[op.rd] = ~(gpr[op.rs] | gpr[op.rt]);
 		}
 
 		//MIPS I
-		void orop(uint32_t instruction)
+		void orop(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3237,14 +4121,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "OR %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "OR %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			printNotifs(7, "OR = %x | %x = %x\n", gpr[rs], gpr[rt], gpr[rs] | gpr[rt]);
-			gpr[rd] = gpr[rs] | gpr[rt];
+			printNotifs(7, "OR = %x | %x = %x\n", gpr[op.rs], gpr[op.rt], gpr[op.rs] | gpr[op.rt]);
+			gpr[op.rd] = gpr[op.rs] | gpr[op.rt];
 		}
 
 		//MIPS I
-		void ori(uint32_t instruction)
+		void ori(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3254,20 +4138,20 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "ORI %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "ORI %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			uint64_t extended = (uint64_t)immediate;
-			gpr[rt] = extended | gpr[rs];
+			uint64_t extended = (uint64_t)op.immediate;
+			gpr[op.rt] = extended | gpr[op.rs];
 		}
 		// MIPS 4
-		void PREF(uint32_t instruction)
+		void PREF(Operands op)
 		{
 			printNotifs(7, "Passing a PREF...\n");
 		}
 
 		// MIPS 32-2
-		void rdhwr(uint32_t instruction)
+		void rdhwr(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3276,17 +4160,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "RDHWR %s, %s", getName(rt).c_str(), getName(rd).c_str());
+				printNotifs(7, "RDHWR %s, %s", getName(op.rt).c_str(), getName(op.rd).c_str());
 			}
-			if(rd > 3 && rd < 29)
+			if(op.rd > 3 && op.rd < 29)
 				signalException(ReservedInstructionException);
-			if(rd >29)
+			if(op.rd >29)
 				signalException(ReservedInstructionException);
-			printNotifs(7, "hwr[%s] is [%ld]\n", getName(rd).c_str(), hwr[rd]);
-			gpr[rt] = hwr[rd];
+			printNotifs(7, "hwr[%s] is [%ld]\n", getName(op.rd).c_str(), (uint64_t)hwr[op.rd]);
+			gpr[op.rt] = hwr[op.rd];
 		}
 		// MIPS 1
-		void sb(uint32_t instruction)
+		void sb(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3295,49 +4179,47 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SB %s, %d(%s)\n", getName(rt).c_str(), immediate, getName(rs).c_str());
+				printNotifs(7, "SB %s, %d(%s)\n", getName(op.rt).c_str(), op.immediate, getName(op.rs).c_str());
 			}
-			uint64_t vAddr = signedImmediate + gpr[rs];
+			uint64_t vAddr = op.signedImmediate + gpr[op.rs];
 			printNotifs(7, "%lx\n", vAddr);
-			char *bytes = memUnit->getWriteAddresss(vAddr, 1, rs, gpr[rs]);
-			if(bytes == NULL)
+			if(!memUnit->store8(vAddr, gpr[op.rt] & 0xff))
 			{
-				printNotifs(7, "%lx, %x, %lld\n", vAddr, signedImmediate, gpr[rs]);
+				printNotifs(7, "%lx, %x, %lld\n", vAddr, op.signedImmediate, (uint64_t)gpr[op.rs]);
 				signalException(MemoryFault);
 			}
-			bytes[0] = gpr[rt] & 0xff;
 			
 		}
 		// MIPS 2
-		void SC(uint32_t instruction)
+		void SC(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 3
-		void SCD(uint32_t instruction)
+		void SCD(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
-		void SD(uint32_t instruction)
+		void SD(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 2
-		void SDCz(uint32_t instruction)
+		void SDCz(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 3
-		void SDL(uint32_t instruction)
+		void SDL(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
-		void SDR(uint32_t instruction)
+		void SDR(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 1
-		void sh(uint32_t instruction)
+		void sh(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3346,29 +4228,18 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SH %s, %d(%s)\n", getName(rt).c_str(), immediate, getName(rs).c_str());
+				printNotifs(7, "SH %s, %d(%s)\n", getName(op.rt).c_str(), op.immediate, getName(op.rs).c_str());
 			}
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-			char *bytes = memUnit->getWriteAddresss(vAddr, 2, rs, gpr[rs]);
-			if(bytes == NULL)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			if(!memUnit->store16(vAddr, gpr[op.rt] & 0xffff))
 			{
 				printNotifs(7, "bytes==NULL\n");
 				signalException(MemoryFault);
 			}
-			if(memUnit->isInStack(vAddr))
-			{
-				bytes[0] = (gpr[rt] >> 8) & 0xff;
-				bytes[-1] = (gpr[rt]) & 0xff;
-			}
-			else
-			{
-				bytes[0] = (gpr[rt] >> 8) & 0xff;
-				bytes[1] = (gpr[rt]) & 0xff;
-			}
 		}
 
 		//MIPS I
-		void sll(uint32_t instruction)
+		void sll(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3378,14 +4249,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLL %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "SLL %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			gpr[rd] = gpr[rt] << sa;
+			gpr[op.rd] = gpr[op.rt] << op.sa;
 		}
 
 		//MIPS I
-		void sllv(uint32_t instruction)
+		void sllv(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3395,14 +4266,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLLV %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "SLLV %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			gpr[rd] = gpr[rt] << (gpr[rs] & 0x1f);
+			gpr[op.rd] = gpr[op.rt] << (gpr[op.rs] & 0x1f);
 		}
 
 		//MIPS I
-		void slt(uint32_t instruction)
+		void slt(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3412,17 +4283,17 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLT %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "SLT %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			int64_t lhs = gpr[rs];
-			int64_t rhs = gpr[rt];
+			int64_t lhs = gpr[op.rs];
+			int64_t rhs = gpr[op.rt];
 
 
-			gpr[rd] = (lhs < rhs);
+			gpr[op.rd] = (lhs < rhs);
 		}
 
 		//MIPS I
-		void slti(uint32_t instruction)
+		void slti(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3432,17 +4303,17 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLTI %s, %s, %x\n", getName(rt).c_str(), getName(rs).c_str(), immediate);
+				printNotifs(7, "SLTI %s, %s, %x\n", getName(op.rt).c_str(), getName(op.rs).c_str(), op.immediate);
 			}
 
-			int64_t extended = (int64_t) immediate;
-			int64_t lhs = gpr[rs];
-			gpr[rt] = lhs < extended;
+			int64_t extended = (int64_t) op.immediate;
+			int64_t lhs = gpr[op.rs];
+			gpr[op.rt] = lhs < extended;
 		}
 
 		//MIPS I
 		//@might not be how casting works.
-		void sltui(uint32_t instruction)
+		void sltui(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3452,27 +4323,27 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLTIU %s, %s, %x\n", getName(rt).c_str(), getName(rs).c_str(), immediate);
+				printNotifs(7, "SLTIU %s, %s, %x\n", getName(op.rt).c_str(), getName(op.rs).c_str(), op.immediate);
 			}
-			if (is64bit)
+			if constexpr (is64bit)
 			{
-				uint64_t extended = (uint64_t)immediate;
+				uint64_t extended = (uint64_t)op.immediate;
 				uint64_t rhs = extended, 
-						 lhs = gpr[rs];
-				gpr[rt] = lhs < rhs;
+						 lhs = gpr[op.rs];
+				gpr[op.rt] = lhs < rhs;
 			}
 			else
 			{
-				uint32_t extended = (uint32_t)signedImmediate;
+				uint32_t extended = (uint32_t)op.signedImmediate;
 				uint64_t rhs = extended & 0xffffffff,
-						 lhs = gpr[rs] & 0xffffffff;
-				gpr[rt] = lhs < rhs;
+						 lhs = gpr[op.rs] & 0xffffffff;
+				gpr[op.rt] = lhs < rhs;
 			}
 			
 		}
 
 		//MIPS I
-		void sltu(uint32_t instruction)
+		void sltu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3482,13 +4353,13 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SLTU %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "SLTU %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			uint64_t a = gpr[rs], b = gpr[rt];
-			gpr[rd] = a < b;
+			uint64_t a = gpr[op.rs], b = gpr[op.rt];
+			gpr[op.rd] = a < b;
 		}
-		void sra(uint32_t instruction)
+		void sra(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3498,22 +4369,22 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SRA %s, %s, %x\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "SRA %s, %s, %x\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			int32_t hold = gpr[rt] & 0xffffffff;
-			hold >>= sa;
-			if (is64bit)
-				gpr[rd] = (int64_t)hold;
+			int32_t hold = gpr[op.rt] & 0xffffffff;
+			hold >>= op.sa;
+			if constexpr (is64bit)
+				gpr[op.rd] = (int64_t)hold;
 			else
 			{
-				gpr[rd] = hold;
-				gpr[rd] &= 0xffffffff;
+				gpr[op.rd] = hold;
+				gpr[op.rd] &= 0xffffffff;
 			}
 		}
 
 		//MIPS I
-		void srav(uint32_t instruction)
+		void srav(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3523,20 +4394,20 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SRAV %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "SRAV %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			int32_t hold = gpr[rt] & 0xffffffff;
-			hold >>= (gpr[rs] & 0x1f);
-			if (is64bit)
-				gpr[rd] = (int64_t)hold;
+			int32_t hold = gpr[op.rt] & 0xffffffff;
+			hold >>= (gpr[op.rs] & 0x1f);
+			if constexpr (is64bit)
+				gpr[op.rd] = (int64_t)hold;
 			else
 			{
-				gpr[rd] = hold;
-				gpr[rd] &= 0xffffffff;
+				gpr[op.rd] = hold;
+				gpr[op.rd] &= 0xffffffff;
 			}
 		}
-		void srl(uint32_t instruction)
+		void srl(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3546,14 +4417,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SRL %s, %s, %d\n", getName(rd).c_str(), getName(rt).c_str(), sa);
+				printNotifs(7, "SRL %s, %s, %d\n", getName(op.rd).c_str(), getName(op.rt).c_str(), op.sa);
 			}
 
-			uint32_t hold = gpr[rt];
-			hold >>= sa;
-			gpr[rd] = hold;
+			uint32_t hold = gpr[op.rt];
+			hold >>= op.sa;
+			gpr[op.rd] = hold;
 		}
-		void srlv(uint32_t instruction)
+		void srlv(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3563,16 +4434,16 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "SRLV %s, %s, %s\n", getName(rd).c_str(), getName(rt).c_str(), getName(rs).c_str());
+				printNotifs(7, "SRLV %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rt).c_str(), getName(op.rs).c_str());
 			}
 
-			uint32_t hold = gpr[rt];
-			hold >>= (gpr[rs] & 0x1f);
-			gpr[rd] = hold;
+			uint32_t hold = gpr[op.rt];
+			hold >>= (gpr[op.rs] & 0x1f);
+			gpr[op.rd] = hold;
 		}
 
 		//MIPS I
-		void sub(uint32_t instruction)
+		void sub(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3581,19 +4452,19 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SUB %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "SUB %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] - gpr[rt];
+			uint64_t temp = gpr[op.rs] - gpr[op.rt];
 			uint64_t flag = BIT32;
 
-			if (((flag & gpr[rs]) == (flag & gpr[rt])) && ((flag & temp) != (flag & gpr[rs])))
+			if (((flag & gpr[op.rs]) == (flag & gpr[op.rt])) && ((flag & temp) != (flag & gpr[op.rs])))
 			{
 				signalException(IntegerOverflow);
 			}
 
-			gpr[rd] = temp;
+			gpr[op.rd] = temp;
 		}
-		void subu(uint32_t instruction)
+		void subu(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3602,17 +4473,14 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SUBU %s, %s, %s\n", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "SUBU %s, %s, %s\n", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			uint64_t temp = gpr[rs] - gpr[rt];
-			if (!is64bit)
-				temp &= 0xffffffff;
-			gpr[rd] = temp;
+			uint64_t temp = gpr[op.rs] - gpr[op.rt];
+			gpr[op.rd] = temp;
 		}
-		void sw(uint32_t instruction)
+		void sw(Operands op)
 		{
 			bool BigEndian = true;
-			is64bit = false;
 			if (mipsTarget < 1)
 			{
 				printNotifs(4, "Invalid mips target for SW\n");
@@ -3620,79 +4488,34 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SW %s, %d(%s)\n", getName(rt).c_str(), immediate, getName(rs).c_str());
+				printNotifs(7, "SW %s, %d(%s)\n", getName(op.rt).c_str(), op.immediate, getName(op.rs).c_str());
 			}
 
 
 		
-			if (is64bit)
+			int32_t offset = op.immediate;
+			if(op.immediate & 3 > 0)
 			{
-
+				printNotifs(2, "Unaligned offset exception in SW\n");
+				signalException(MemoryFault);
 			}
-			else
-			{
-				int32_t offset = immediate;
-				if(immediate & 3 > 0)
-				{
-					printNotifs(2, "Unaligned offset exception in SW\n");
-					signalException(MemoryFault);
-				}
-					
 				
-				//Destination address
-				uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-				//Get bytes in-order from mmu
-				//memUnit->printSections();
-				fflush(stdout);
-				char *bytes = memUnit->getWriteAddresss(vAddr, 4, rs, gpr[rs]);
-				fflush(stdout);
-				if(bytes == NULL)
-				{
-					printNotifs(7, "bytes==NULL\n");
-					signalException(MemoryFault);
-				}
-				//change their order depending on endianness??
-
-				//The emulated pointer for the stack is backwards. Have to reverse it for writes
-				if(memUnit->isInStack(vAddr))
-				{
-					bytes[0] = (gpr[rt] >> 24) & 0xff;
-					bytes[-1] = (gpr[rt] >> 16) & 0xff;
-					bytes[-2] = (gpr[rt] >> 8) & 0xff;
-					bytes[-3] = (gpr[rt]) & 0xff;
-				}
-				else 
-				{
-					bytes[0] = (gpr[rt] >> 24) & 0xff;
-					bytes[1] = (gpr[rt] >> 16) & 0xff;
-					bytes[2] = (gpr[rt] >> 8) & 0xff;
-					bytes[3] = (gpr[rt]) & 0xff;
-				}
-				//printf("victory? %s, %c%c%c%c, %hhx%hhx%hhx%hhx\n", getName(rt).c_str(), bytes[0], bytes[1], bytes[2], bytes[3], 
-				//																		bytes[0], bytes[1], bytes[2], bytes[3]);
-				/*if(BigEndian)
-				{
-					for(int i=0;i<4;i++)
-					{
-						gpr[rt] &= bytes[i] << i*8;
-					}
-				}
-				else
-				{
-					for(int i=0;i<4;i++)
-					{
-						gpr[rt] &= bytes[3-i] << i*8;
-					}
-				*/
+			
+			//Destination address
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			if(!memUnit->store32(vAddr, gpr[op.rt] & 0xffffffff))
+			{
+				printNotifs(7, "bytes==NULL\n");
+				signalException(MemoryFault);
 			}
 		}
-		void swcz(uint32_t instruction)
+		void swcz(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 
 		//MIPS 1
-		void swl(uint32_t instruction)
+		void swl(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3701,48 +4524,25 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SWL %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "SWL %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
-			bool BigEndian = true;
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-
-			int i = vAddr & 3, j = 24, k = 0;
-			char *bytes = memUnit->getWriteAddresss(vAddr, 4-i, rs, 0);
-			if(bytes == NULL)
-				signalException(MemoryFault);
-				
-
-
-
-			if(BigEndian)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			int i = vAddr & 3;
+			// The top of rt goes to the bytes from vAddr to the end of its word
+			if(i == 0)
 			{
-				if(memUnit->isInStack(vAddr))
-				{
-					while(i <= 3)
-					{
-						bytes[k] = (gpr[rt] >> j) & 0xff;
-						i++;
-						j -= 8;
-						k--;
-					}
-				}
-				else
-				{
-					while(i <= 3)
-					{
-						bytes[k] = (gpr[rt] >> j) & 0xff;
-						i++;
-						j -= 8;
-						k++;
-					}
-				}
+				if(!memUnit->store32(vAddr, gpr[op.rt] & 0xffffffff))
+					signalException(MemoryFault);
+				return;
+			}
+			for(int k = 0; k < 4 - i; k++)
+			{
+				if(!memUnit->store8(vAddr + k, (gpr[op.rt] >> (24 - 8 * k)) & 0xff))
+					signalException(MemoryFault);
 			}
-
-			
-
 		}
-		void swr(uint32_t instruction)
+		void swr(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -3751,61 +4551,40 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "SWR %s, %d(%s)\n", getName(rt).c_str(), signedImmediate, getName(rs).c_str());
+				printNotifs(7, "SWR %s, %d(%s)\n", getName(op.rt).c_str(), op.signedImmediate, getName(op.rs).c_str());
 			}
 
-			bool BigEndian = true;
-			uint64_t vAddr = (int64_t)signedImmediate + gpr[rs];
-
-			int i = vAddr & 3, j = 0, k = 0;
-			char *bytes = memUnit->getWriteAddresss(vAddr - i, i, rs, 0);
-			if(bytes == NULL)
-				signalException(MemoryFault);
-			if(memUnit->isInStack(vAddr))
-				bytes -= i;
-			else
-				bytes += i;
-			
-			if(BigEndian)
+			uint64_t vAddr = (int64_t)op.signedImmediate + gpr[op.rs];
+			int i = vAddr & 3;
+			// The bottom of rt goes to the bytes from the start of vAddr's word up to vAddr
+			if(i == 3)
 			{
-				if(memUnit->isInStack(vAddr))
-				{
-					while(i >= 0)
-					{
-						bytes[k] = (gpr[rt] >> j) & 0xff;
-						i--;
-						j += 8;
-						k++;
-					}
-				}
-				else
-				{
-					while(i >= 0)
-					{
-						printNotifs(7, "writing to %x\n", bytes+k);
-						bytes[k] = (gpr[rt] >> j) & 0xff;
-						i--;
-						j += 8;
-						k--;
-					}
-				}
+				if(!memUnit->store32(vAddr - 3, gpr[op.rt] & 0xffffffff))
+					signalException(MemoryFault);
+				return;
+			}
+			for(int k = 0; k <= i; k++)
+			{
+				printNotifs(7, "writing to %lx\n", vAddr - k);
+				if(!memUnit->store8(vAddr - k, (gpr[op.rt] >> (8 * k)) & 0xff))
+					signalException(MemoryFault);
 			}
 		}
 		// MIPS 2
-		void SYNC(uint32_t instruction)
+		void SYNC(Operands op)
 		{
-			unimplemented(instruction);
+			unimplemented(op);
 		}
 		// MIPS 1
-		void syscall(uint32_t instruction)
+		void syscall(Operands op)
 		{
 			printNotifs(2, "Syscall performed. Unimplemented, generally!\n");
-			printNotifs(7, "$v0 is 0x%lx.\n", gpr[2]);
+			printNotifs(7, "$v0 is 0x%lx.\n", (uint64_t)gpr[2]);
 			
 			
 		}
 		// MIPS 2
-		void teq(uint32_t instruction)
+		void teq(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3814,17 +4593,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TEQ %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TEQ %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if(gpr[rs] == gpr[rt])
+			if(gpr[op.rs] == gpr[op.rt])
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void teqi(uint32_t instruction)
+		void teqi(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3833,17 +4612,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TEQI %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TEQI %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			if(gpr[rs] == signedImmediate)
+			if(gpr[op.rs] == op.signedImmediate)
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tge(uint32_t instruction)
+		void tge(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3852,10 +4631,10 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TGE %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TGE %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
-			int64_t comp1 = (int64_t) gpr[rs];
-			int64_t comp2 = (int64_t) gpr[rt];
+			int64_t comp1 = (int64_t) gpr[op.rs];
+			int64_t comp2 = (int64_t) gpr[op.rt];
 			if(comp1 >= comp2)
 			{
 				signalException(TrapFault);
@@ -3864,7 +4643,7 @@ class EmulatedCPU
 
 		//MIPS II
 		//@check comparison
-		void tgei(uint32_t instruction)
+		void tgei(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3873,17 +4652,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TGEI %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TGEI %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 
-			if(gpr[rs] >= signedImmediate)
+			if(gpr[op.rs] >= op.signedImmediate)
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tgeiu(uint32_t instruction)
+		void tgeiu(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3892,15 +4671,15 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TGEIU %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TGEIU %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
-			uint64_t comparison = (int64_t) signedImmediate;
-			if(gpr[rs] >= comparison)
+			uint64_t comparison = (int64_t) op.signedImmediate;
+			if(gpr[op.rs] >= comparison)
 			{
 				signalException(TrapFault);
 			}
 		}
-		void tgeu(uint32_t instruction)
+		void tgeu(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3909,17 +4688,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TGEU %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TGEU %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			if(gpr[rs] >= gpr[rt])
+			if(gpr[op.rs] >= gpr[op.rt])
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tlt(uint32_t instruction)
+		void tlt(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3928,11 +4707,11 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TLT %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TLT %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			int64_t comp1 = (int64_t) gpr[rs];
-			int64_t comp2 = (int64_t) gpr[rt];
+			int64_t comp1 = (int64_t) gpr[op.rs];
+			int64_t comp2 = (int64_t) gpr[op.rt];
 			if(comp1 < comp2)
 			{
 				signalException(TrapFault);
@@ -3940,7 +4719,7 @@ class EmulatedCPU
 		}
 
 		//MIPS II
-		void tlti(uint32_t instruction)
+		void tlti(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3949,17 +4728,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TLTI %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TLTI %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
-			int64_t comparison = (int64_t) signedImmediate;
-			if(gpr[rs] < comparison)
+			int64_t comparison = (int64_t) op.signedImmediate;
+			if(gpr[op.rs] < comparison)
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tltiu(uint32_t instruction)
+		void tltiu(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3968,17 +4747,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TLTIU %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TLTIU %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
-			uint64_t comparison = (int64_t) signedImmediate;
-			if(gpr[rs] < comparison)
+			uint64_t comparison = (int64_t) op.signedImmediate;
+			if(gpr[op.rs] < comparison)
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tltu(uint32_t instruction)
+		void tltu(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -3987,17 +4766,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TLTU %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TLTU %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 			
-			if(gpr[rs] < gpr[rt])
+			if(gpr[op.rs] < gpr[op.rt])
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS II
-		void tne(uint32_t instruction)
+		void tne(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -4006,15 +4785,15 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TNE %s, %s\n", getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "TNE %s, %s\n", getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 			
-			if(gpr[rs] != gpr[rt])
+			if(gpr[op.rs] != gpr[op.rt])
 			{
 				signalException(TrapFault);
 			}
 		}
-		void tnei(uint32_t instruction)
+		void tnei(Operands op)
 		{
 			if (mipsTarget < 2)
 			{
@@ -4023,17 +4802,17 @@ class EmulatedCPU
 
 			if (debugPrint)
 			{
-				printNotifs(7, "TNEI %s, %d\n", getName(rs).c_str(), signedImmediate);
+				printNotifs(7, "TNEI %s, %d\n", getName(op.rs).c_str(), op.signedImmediate);
 			}
 			
-			if(gpr[rs] != signedImmediate)
+			if(gpr[op.rs] != op.signedImmediate)
 			{
 				signalException(TrapFault);
 			}
 		}
 
 		//MIPS 1
-		void xorop(uint32_t instruction)
+		void xorop(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -4043,14 +4822,14 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "XOR %s, %s, %s", getName(rd).c_str(), getName(rs).c_str(), getName(rt).c_str());
+				printNotifs(7, "XOR %s, %s, %s", getName(op.rd).c_str(), getName(op.rs).c_str(), getName(op.rt).c_str());
 			}
 
-			gpr[rd] = gpr[rs] ^ gpr[rt];
+			gpr[op.rd] = gpr[op.rs] ^ gpr[op.rt];
 		}
 
 		//MIPS I
-		void xori(uint32_t instruction)
+		void xori(Operands op)
 		{
 			if (mipsTarget < 1)
 			{
@@ -4060,10 +4839,10 @@ class EmulatedCPU
 			if (debugPrint)
 			{
 
-				printNotifs(7, "XORI %s, %s, %x", getName(rd).c_str(), getName(rs).c_str(), immediate);
+				printNotifs(7, "XORI %s, %s, %x", getName(op.rd).c_str(), getName(op.rs).c_str(), op.immediate);
 			}
 
-			gpr[rt] = gpr[rs] ^ immediate;
+			gpr[op.rt] = gpr[op.rs] ^ op.immediate;
 		}
 		
 		//@dontuse
@@ -4087,7 +4866,7 @@ class EmulatedCPU
 					return;
 				}
 			}
-			if (is64bit)
+			if constexpr (is64bit)
 				*target |= *target & bitn ? mask : 0;
 			else
 			{
@@ -4162,7 +4941,7 @@ class EmulatedCPU
 				{
 					printf("\x1b[42m");
 				}
-				printf("%4s -> 0x%08lx\t", getName(i).c_str(), gpr[i]);
+				printf("%4s -> 0x%08lx\t", getName(i).c_str(), (uint64_t)gpr[i]);
 				if(isValidMemoryPtr)
 					printf("\x1b[0m");
 
@@ -4173,7 +4952,7 @@ class EmulatedCPU
 					break;
 					case 1: printf("| pc: 0x%lx", pc);
 					break;
-					case 2: printf("| Stack Size: 0x%x", memUnit->stack.size());
+					case 2: printf("| Stack Size: 0x%x", memUnit->stackSize);
 					break;
 					case 3: printf("| Instructions run: %d", instructionsRun);
 					break;
@@ -4216,35 +4995,21 @@ class EmulatedCPU
 						char *bytes = memUnit->getEffectiveAddress(vAddr, 4, 0, 0, true);
 						
 						if(memUnit->isInStack(vAddr))
-						{
 							printf("[Stack]  ");
-							loadedWord = 0;
-							if(memUnit->isInMemory(vAddr + 4))
-							{
-								loadedWord |= (uint64_t)(bytes[-3] & 0xff);
-								loadedWord |= ((uint64_t)(bytes[-2] & 0xff)) << 8;
-								loadedWord |= ((uint64_t)(bytes[-1] & 0xff)) << 16;
-								loadedWord |= ((uint64_t)(bytes[0] & 0xff)) << 24;
-							}
-							
-						}
-						else
+						if (memUnit->MMUHeap.isInHeap(vAddr))
+							printf("[Heap]   ");
+						if (memUnit->isInBinary(vAddr))
+							printf("[Binary] ");
+						loadedWord = 0;
+						if(memUnit->isInMemory(vAddr + 4))
 						{
-							if (memUnit->MMUHeap.isInHeap(vAddr))
-								printf("[Heap]   ");
-							if (memUnit->isInBinary(vAddr))
-								printf("[Binary] ");
-							loadedWord = 0;
-							if(memUnit->isInMemory(vAddr + 4))
-							{
-								loadedWord |= (uint64_t)(bytes[3] & 0xff);
-								loadedWord |= ((uint64_t)(bytes[2] & 0xff)) << 8;
-								loadedWord |= ((uint64_t)(bytes[1] & 0xff)) << 16;
-								loadedWord |= ((uint64_t)(bytes[0] & 0xff)) << 24;
-							}
-							
+							loadedWord |= (uint64_t)(bytes[3] & 0xff);
+							loadedWord |= ((uint64_t)(bytes[2] & 0xff)) << 8;
+							loadedWord |= ((uint64_t)(bytes[1] & 0xff)) << 16;
+							loadedWord |= ((uint64_t)(bytes[0] & 0xff)) << 24;
 						}
 						
+						
 						if(i-22 >= 0 && i-22 < validRegIndices.size())
 						{
 							printf("%s: 0x%08x", getName(validRegIndices[i-22]).c_str(), loadedWord);
@@ -4270,7 +5035,7 @@ class EmulatedCPU
 			printf("=================DUMPING REGISTERS:=================\n");
 			for (i = 0; i < 32; i++)
 			{
-				printf("%s -> %lx\n", getName(i).c_str(), gpr[i]);
+				printf("%s -> %lx\n", getName(i).c_str(), (uint64_t)gpr[i]);
 			}
 		}
 		std::string getName(int offset)
@@ -4342,15 +5107,9 @@ class EmulatedCPU
 			return out.str();
 		}
 
-		void printNotifs(int logLevel = 7, const char* notif = "", ...)
+		// Prints a notification, use printNotifs which skips it when the level is off.
+		void logNotif(int logLevel, const char* notif, ...)
 		{
-			// if (logLevel > 3) return;
-			if(beQuietFlag)
-				return;
-
-			if(globalLogLevel > logLevel)
-				return;
-				
 			// Print the logLevel before the notification
 			switch (logLevel)
 			{
@@ -4390,48 +5149,23 @@ class EmulatedCPU
 		// pg. 40
 		void runInstruction(uint32_t instruction)
 		{
-			printNotifs(6, "PC: [0x%lx], Instruction: [0x%08x]\n", pc, instruction);
-			// First, let's determine the instruction type.
-			rs = (instruction & 0x3E00000) >> 21;
-			rt = (instruction & 0x1F0000) >> 16;
-			rd = (instruction & 0xf800) >> 11;
-			sa = (instruction & 0x7c0) >> 6;
-			immediate = instruction & 0xffff;
-			signedImmediate = immediate;
+			DecodedInstruction decoded;
+			decodeInstruction(instruction, &decoded);
+			runDecoded(&decoded);
+		}
 
-			if (is64bit == false)
-			{
-				int i;
-				for (i = 0; i < 32; i++)
-				{
-					gpr[i] = gpr[i] & 0xFFFFFFFF;
-				}
-			}
-			
-			//printf("immediate signed: %d immediate unsigned: %d\n", signedImmediate, immediate);
-			//printf("Rtype [%d]\n", (instruction & 0b111111));
-			//printf("Regimm [%d]\n", ((instruction & 0x1f0000) >> 16));
-			//printf("Otype [%d]\n", ((instruction & 0xfc000000) >> 26));
-			// TODO: add bounds checking : )
-			// If the upper 26-31 bits are set to zero, then, we have an R-Type instruction
-			if ((instruction & 0xfc000000) == 0)
-			{
-				// Essentially, this is a list of r type functions indexed by opcode.
-				//printf("Selected Rtype [%d]\n", (instruction & 0b111111));
-				(this->*inst_handlers_rtypes[(instruction & 0b111111)])(instruction);
-							
-			}
-			// If the upper 26-31 bits are set to one, then, we have a REGIMM instruction
-			else if ((instruction & 0xfc000000) >> 26 == 1)
-			{
-				//printf("Selected Regimm [%d]\n", ((instruction & 0x1f0000) >> 16));
-				(this->*inst_handlers_regimm[((instruction & 0x1f0000) >> 16)])(instruction);
-			}
-			else
-			{
-				//printf("Selected Otype [%d]\n", ((instruction & 0xfc000000) >> 26));
-				(this->*inst_handlers_otypes[(instruction & 0xfc000000) >> 26])(instruction);
-			}			
+		// Calls the handler of a decoded record with its fields.
+		void runDecoded(const DecodedInstruction *decoded)
+		{
+			printNotifs(6, "PC: [0x%lx], Instruction: [0x%08x]\n", pc, decoded->instruction);
+			if (logRing != NULL)
+				logRing->record(instructionsRun, pc, decoded->instruction);
+
+#ifdef THREADED_DISPATCH
+			decoded->dispatch(this, *decoded);
+#else
+			(this->*(decoded->handler))(*decoded);
+#endif
 		}
 		Ref<BinaryView> createBinjaAnalysis(char *filePath)
 		{
@@ -4489,6 +5223,9 @@ class EmulatedCPU
 		}
 };
 
+// Only the Mips32 core is run today, instantiate the Mips64 one too so it keeps compiling.
+template class EmulatedCPU<Mips64>;
+
 void electricRockLogo(void)
 {
 	const char *cloud[12] = {"    .deez...      .....       .eeec.   ..eee..",
@@ -4645,6 +5382,56 @@ int main(int argn, char ** args)
 		.nargs(1)
 		.help("Set a testcase to read input from.");
 
+	program.add_argument("--noblocks")
+		.help("Run one instruction at a time instead of translated blocks.")
+		.default_value(false)
+		.implicit_value(true);
+
+	program.add_argument("--jit")
+		.help("Compile hot blocks to x86-64 (needs --quiet or --timer).")
+		.default_value(false)
+		.implicit_value(true);
+
+	program.add_argument("--logring")
+		.default_value(std::string(""))
+		.nargs(1)
+		.help("Record the last executed instructions to a binary log ring file.");
+
+	program.add_argument("--readlog")
+		.default_value(std::string(""))
+		.nargs(1)
+		.help("Print a log ring file recorded with --logring, instead of emulating.");
+
+	program.add_argument("--core")
+		.default_value(std::string(""))
+		.nargs(1)
+		.help("Write the guest state to a core file when an exception is signalled.");
+
+	program.add_argument("--loadcore")
+		.default_value(std::string(""))
+		.nargs(1)
+		.help("Resume from a core file written with --core, instead of starting at main.");
+
+	program.add_argument("--maxheap")
+		.scan<'u', uint64_t>()
+		.default_value((uint64_t)0)
+		.help("Fault when the guest heap would grow past this many bytes (0 for no limit).");
+
+	program.add_argument("--maxstack")
+		.scan<'u', uint64_t>()
+		.default_value((uint64_t)0)
+		.help("Fault when the guest stack would grow past this many bytes (0 for no limit).");
+
+	program.add_argument("--maxdirty")
+		.scan<'u', uint64_t>()
+		.default_value((uint64_t)0)
+		.help("Fault when more than this many guest pages have been written (0 for no limit).");
+
+	program.add_argument("--maxrss")
+		.scan<'u', uint64_t>()
+		.default_value((uint64_t)0)
+		.help("Fault when the emulator's resident memory passes this many bytes (0 for no limit).");
+
 
 
 	try 
@@ -4664,6 +5451,11 @@ int main(int argn, char ** args)
 	auto killpoints_path = program.get<std::string>("killpoints");
 	auto outputfile_path = program.get<std::string>("outputfile");
 	auto single_path = program.get<std::string>("single");
+	auto core_path = program.get<std::string>("--core");
+	defaultLimits.heapBytes = program.get<uint64_t>("--maxheap");
+	defaultLimits.stackBytes = program.get<uint64_t>("--maxstack");
+	defaultLimits.dirtyPages = program.get<uint64_t>("--maxdirty");
+	defaultLimits.rssBytes = program.get<uint64_t>("--maxrss");
 
 	// Usage of optional args --pcout and --reg
 	if (program["--pcout"] == true)
@@ -4686,6 +5478,27 @@ int main(int argn, char ** args)
 		beQuietFlag = true;
 	}
 
+	if (program["--noblocks"] == true)
+	{
+		blockEngine = false;
+	}
+
+	if (program.get<std::string>("--logring").length() != 0)
+	{
+		logRing = new LogRing(program.get<std::string>("--logring").c_str());
+		if (!logRing->valid())
+			raise(SIGKILL);
+	}
+
+	if (program["--jit"] == true)
+	{
+#if defined(__x86_64__)
+		jitMode = true;
+#else
+		printf("--jit is only supported on x86-64 hosts, running interpreted.\n");
+#endif
+	}
+
 	if (program["--timer"] == true)
 	{
 		//printf("Setting flag for timer and beQuiet to true!\n");
@@ -4824,13 +5637,42 @@ int main(int argn, char ** args)
 	system("clear");
 
 	// Begin Emulation
-	EmulatedCPU* electricrock = new EmulatedCPU(false, bv);
+	EmulatedCPU<Mips32>* electricrock = new EmulatedCPU<Mips32>(bv);
 	
+	if (program.get<std::string>("--readlog").length() != 0)
+	{
+		LogRing ring(program.get<std::string>("--readlog").c_str(), false);
+		if (ring.valid())
+		{
+			for (uint64_t i = 0; i < ring.held(); i++)
+			{
+				const LogRecord& record = ring.oldest(i);
+				printf("[%llu] 0x%08x: %08x %s\n", (unsigned long long) record.instructionsRun, record.pc,
+					record.instruction, electricrock->getInstructionName(record.instruction));
+			}
+		}
+		BNShutdown();
+		return 0;
+	}
 	
+	if (core_path.length() != 0)
+		corePath = core_path.c_str();
+
 	//(uint32_t)bv->GetEntryPoint()
 	//electricrock->startOfMain
 	//system("clear");
-	electricrock->runEmulation(electricrock->startOfMain);
+	if (program.get<std::string>("--loadcore").length() != 0)
+	{
+		if (!electricrock->readCore(program.get<std::string>("--loadcore").c_str()))
+		{
+			BNShutdown();
+			return -1;
+		}
+		electricrock->runEmulation(electricrock->pc);
+	}
+	else
+		electricrock->runEmulation(electricrock->startOfMain);
+	electricrock->memUnit->printUsage();
 
 	// Proper shutdown of core
 	BNShutdown();
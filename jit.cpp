@@ -0,0 +1,209 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+
+#ifndef JITCPP
+#define JITCPP 1
+#endif
+
+// Size of the executable region compiled blocks are placed in.
+#define CODE_CACHE_SIZE (16 * 1024 * 1024)
+
+// The host side of the --jit mode: an executable code region and the handful of x86-64
+// encodings the block compiler in emulator.cpp needs. Compiled blocks keep the base of the
+// guest gpr[] array (32 bit words) pinned in rbx and the EmulatedCPU pointer in r12.
+// The region is never writable and executable at once: emitting happens between
+// beginEmit() and endEmit(), and native code only runs while it is read and execute.
+class CodeCache
+{
+public:
+	unsigned char *base = NULL;
+	unsigned char *cursor = NULL;
+	unsigned char *blockStart = NULL;
+	bool writable = true;
+
+	CodeCache()
+	{
+		void *region = mmap(NULL, CODE_CACHE_SIZE, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		if (region == MAP_FAILED)
+		{
+			printf("Could not map the JIT code cache, running interpreted.\n");
+			return;
+		}
+		base = (unsigned char *) region;
+		cursor = base;
+	}
+
+	~CodeCache()
+	{
+		if (base != NULL)
+			munmap(base, CODE_CACHE_SIZE);
+	}
+
+	// Makes the region writable for emitting. False if it cannot be, then nothing may be
+	// emitted.
+	bool beginEmit()
+	{
+		if (!writable && mprotect(base, CODE_CACHE_SIZE, PROT_READ | PROT_WRITE) != 0)
+			return false;
+		writable = true;
+		return true;
+	}
+
+	// Makes the region executable again once emitting is done. False if it could not be,
+	// then nothing in it may be run.
+	bool endEmit()
+	{
+		if (mprotect(base, CODE_CACHE_SIZE, PROT_READ | PROT_EXEC) != 0)
+			return false;
+		writable = false;
+		return true;
+	}
+
+	// Throws away everything compiled so far.
+	void reset()
+	{
+		cursor = base;
+	}
+
+	// Whether a block of up to n bytes still fits.
+	bool hasRoom(int n)
+	{
+		return base != NULL && cursor + n <= base + CODE_CACHE_SIZE;
+	}
+
+	void emit8(uint8_t b)
+	{
+		*cursor++ = b;
+	}
+
+	void emit32(uint32_t v)
+	{
+		memcpy(cursor, &v, 4);
+		cursor += 4;
+	}
+
+	void emit64(uint64_t v)
+	{
+		memcpy(cursor, &v, 8);
+		cursor += 8;
+	}
+
+	void emitBytes(const char *bytes, int n)
+	{
+		memcpy(cursor, bytes, n);
+		cursor += n;
+	}
+
+	// push rbx; push r12; sub rsp, 8; mov rbx, rsi; mov r12, rdi
+	void prologue()
+	{
+		blockStart = cursor;
+		emitBytes("\x53\x41\x54\x48\x83\xEC\x08\x48\x89\xF3\x49\x89\xFC", 13);
+	}
+
+	// mov eax, imm32; add rsp, 8; pop r12; pop rbx; ret
+	void epilogue(uint32_t result)
+	{
+		emit8(0xB8);
+		emit32(result);
+		emitBytes("\x48\x83\xC4\x08\x41\x5C\x5B\xC3", 8);
+	}
+
+	// <op> eax, dword [rbx + disp32], with op one of the 0x03-style opcodes (mov is 0x8B).
+	void aluLoad(uint8_t opcode, int32_t disp)
+	{
+		emit8(opcode);
+		emit8(0x83);
+		emit32(disp);
+	}
+
+	// <op> eax, imm32, with op one of the 0x05-style short forms.
+	void aluImmediate(uint8_t opcode, uint32_t imm)
+	{
+		emit8(opcode);
+		emit32(imm);
+	}
+
+	// mov dword [rbx + disp32], eax
+	void storeEax(int32_t disp)
+	{
+		emit8(0x89);
+		emit8(0x83);
+		emit32(disp);
+	}
+
+	// mov eax, imm32
+	void loadEax(uint32_t imm)
+	{
+		emit8(0xB8);
+		emit32(imm);
+	}
+
+	// not eax
+	void notEax()
+	{
+		emitBytes("\xF7\xD0", 2);
+	}
+
+	// shl eax, n / shr eax, n / sar eax, n
+	void shiftLeftEax(uint8_t n)
+	{
+		emitBytes("\xC1\xE0", 2);
+		emit8(n);
+	}
+
+	void shiftRightEax(uint8_t n)
+	{
+		emitBytes("\xC1\xE8", 2);
+		emit8(n);
+	}
+
+	void shiftRightArithmeticEax(uint8_t n)
+	{
+		emitBytes("\xC1\xF8", 2);
+		emit8(n);
+	}
+
+	// setb al; movzx eax, al
+	void setBelow()
+	{
+		emitBytes("\x0F\x92\xC0\x0F\xB6\xC0", 6);
+	}
+
+	// Calls fn(cpu, arg1, arg2, arg3) with the cpu pointer taken from r12.
+	void callHelper(void *fn, uint64_t arg1, uint32_t arg2, uint32_t arg3)
+	{
+		// mov rdi, r12
+		emitBytes("\x4C\x89\xE7", 3);
+		// mov rsi, imm64
+		emitBytes("\x48\xBE", 2);
+		emit64(arg1);
+		// mov edx, imm32
+		emit8(0xBA);
+		emit32(arg2);
+		// mov ecx, imm32
+		emit8(0xB9);
+		emit32(arg3);
+		// mov rax, imm64; call rax
+		emitBytes("\x48\xB8", 2);
+		emit64((uint64_t) fn);
+		emitBytes("\xFF\xD0", 2);
+	}
+};
+
+// x86-64 opcodes used with aluLoad and aluImmediate.
+#define X86_MOV_LOAD 0x8B
+#define X86_ADD_LOAD 0x03
+#define X86_SUB_LOAD 0x2B
+#define X86_AND_LOAD 0x23
+#define X86_OR_LOAD 0x0B
+#define X86_XOR_LOAD 0x33
+#define X86_CMP_LOAD 0x3B
+#define X86_ADD_IMM 0x05
+#define X86_AND_IMM 0x25
+#define X86_OR_IMM 0x0D
+#define X86_XOR_IMM 0x35
+#define X86_CMP_IMM 0x3D
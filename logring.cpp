@@ -0,0 +1,119 @@
+#pragma once
+#include <stdint.h>
+#include <stdio.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+
+#ifndef LOGRINGCPP
+#define LOGRINGCPP 1
+#endif
+
+// Records kept by --logring before the oldest are overwritten. Must be a power of two.
+#define LOG_RING_RECORDS (1 << 20)
+#define LOG_RING_MAGIC 0x474e49524745444dULL
+
+// One executed instruction in the --logring trace.
+struct LogRecord
+{
+	uint64_t instructionsRun;
+	uint32_t pc;
+	uint32_t instruction;
+};
+
+// Start of a --logring file, followed by LOG_RING_RECORDS records.
+struct LogRingHeader
+{
+	uint64_t magic;
+	uint64_t capacity;
+	uint64_t written; // Records ever written, the next one goes to written % capacity
+};
+
+// Binary instruction trace for --logring. The file is mapped shared, so a record is three
+// stores with no formatting or write calls, and the trace survives the emulator raising
+// SIGKILL on a fault. --readlog formats it afterwards.
+class LogRing
+{
+public:
+	LogRingHeader *header = NULL;
+	LogRecord *records = NULL;
+	size_t size = 0;
+
+	// Creates the ring at path, or with create false maps an existing one for reading.
+	LogRing(const char *path, bool create = true)
+	{
+		size = sizeof(LogRingHeader) + sizeof(LogRecord) * LOG_RING_RECORDS;
+		int fd = open(path, create ? (O_RDWR | O_CREAT | O_TRUNC) : O_RDONLY, 0644);
+		if (fd < 0)
+		{
+			printf("Could not open the log ring %s\n", path);
+			return;
+		}
+		if (create && ftruncate(fd, size) != 0)
+		{
+			printf("Could not size the log ring %s\n", path);
+			close(fd);
+			return;
+		}
+		struct stat st;
+		if (!create && (fstat(fd, &st) != 0 || (size_t) st.st_size < size))
+		{
+			printf("%s is not a log ring\n", path);
+			close(fd);
+			return;
+		}
+		void *region = mmap(NULL, size, create ? (PROT_READ | PROT_WRITE) : PROT_READ, MAP_SHARED, fd, 0);
+		close(fd);
+		if (region == MAP_FAILED)
+		{
+			printf("Could not map the log ring %s\n", path);
+			return;
+		}
+		header = (LogRingHeader *) region;
+		records = (LogRecord *) (header + 1);
+		if (create)
+		{
+			header->magic = LOG_RING_MAGIC;
+			header->capacity = LOG_RING_RECORDS;
+			header->written = 0;
+		}
+		else if (header->magic != LOG_RING_MAGIC || header->capacity != LOG_RING_RECORDS)
+		{
+			printf("%s is not a log ring\n", path);
+			munmap(region, size);
+			header = NULL;
+			records = NULL;
+		}
+	}
+
+	~LogRing()
+	{
+		if (header != NULL)
+			munmap(header, size);
+	}
+
+	bool valid()
+	{
+		return header != NULL;
+	}
+
+	void record(uint64_t instructionsRun, uint32_t pc, uint32_t instruction)
+	{
+		LogRecord *next = &records[header->written++ & (LOG_RING_RECORDS - 1)];
+		next->instructionsRun = instructionsRun;
+		next->pc = pc;
+		next->instruction = instruction;
+	}
+
+	// Number of records still held, and the i-th oldest of them.
+	uint64_t held()
+	{
+		return header->written < LOG_RING_RECORDS ? header->written : LOG_RING_RECORDS;
+	}
+
+	const LogRecord& oldest(uint64_t i)
+	{
+		return records[(header->written - held() + i) & (LOG_RING_RECORDS - 1)];
+	}
+};
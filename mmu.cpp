@@ -5,7 +5,16 @@
 #include <string.h>
 #include <vector>
 #include <unordered_map>
+#include <unordered_set>
+#include <set>
 #include <algorithm>    // std::max
+#include <signal.h>
+#include <setjmp.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 
 
 #ifndef MMUCPP
@@ -17,6 +26,101 @@
 
 #define BLOCKWIDTH 1024
 
+// Software TLB in front of getEffectiveAddress and getWriteAddresss. Direct mapped on
+// TLB_PAGE_SIZE guest pages; accesses wider than TLB_MAX_ACCESS always take the slow path.
+#define TLB_PAGE_SHIFT 10
+#define TLB_PAGE_SIZE (1 << TLB_PAGE_SHIFT)
+#define TLB_ENTRIES 256
+#define TLB_MAX_ACCESS 8
+
+// Two-level page table over the 32-bit guest space. The top PAGE_DIRECTORY_BITS of an address
+// pick a page table, the next PAGE_TABLE_BITS the page in it.
+#define PAGE_SHIFT 12
+#define PAGE_TABLE_BITS 10
+#define PAGE_DIRECTORY_BITS (32 - PAGE_SHIFT - PAGE_TABLE_BITS)
+#define PAGE_TABLE_SIZE (1 << PAGE_TABLE_BITS)
+
+// Region kinds a page table entry can hold. Regions are not page aligned, so a set bit only
+// says the page touches that region and the region's own bounds still decide.
+#define REGION_BINARY 0b0001
+#define REGION_STACK  0b0010
+#define REGION_HEAP   0b0100
+#define REGION_GUARD  0b1000 // The bytes just above the stack base
+#define REGION_ALL    0b1111
+
+// One entry of an interval index over sections or segments. order is the entry's place in
+// the order the linear searches used to visit them, so the index gives the same answer when
+// ranges overlap. Once built, the index holds disjoint pieces instead, see buildIntervalIndex.
+struct IntervalRef
+{
+	uint64_t start, end;
+	int order;
+
+	friend bool operator<(const IntervalRef& lhs, const IntervalRef& rhs) { return lhs.start < rhs.start; }
+};
+
+// Splits refs into disjoint pieces sorted by start, each holding the lowest order of the
+// entries that cover it. Any address then lies in at most one piece, so a lookup is a single
+// binary search however the entries overlap.
+static void buildIntervalIndex(vector<IntervalRef> &refs)
+{
+	// Entries open at their start and close after their end (-1 - order)
+	vector<pair<uint64_t, int>> events;
+	for (int k = 0;k < refs.size();k++)
+	{
+		if (refs[k].start > refs[k].end)
+			continue;
+		events.push_back({refs[k].start, refs[k].order});
+		if (refs[k].end != UINT64_MAX)
+			events.push_back({refs[k].end + 1, -1 - refs[k].order});
+	}
+	sort(events.begin(), events.end());
+
+	vector<IntervalRef> pieces;
+	set<int> open;
+	for (int k = 0;k < events.size();)
+	{
+		uint64_t at = events[k].first;
+		for (;k < events.size() && events[k].first == at;k++)
+		{
+			if (events[k].second >= 0)
+				open.insert(events[k].second);
+			else
+				open.erase(-1 - events[k].second);
+		}
+		if (open.empty())
+			continue;
+		// The same entries cover everything up to the next event
+		IntervalRef piece;
+		piece.start = at;
+		piece.end = k < events.size() ? events[k].first - 1 : UINT64_MAX;
+		piece.order = *open.begin();
+		if (!pieces.empty() && pieces.back().order == piece.order && pieces.back().end + 1 == piece.start)
+			pieces.back().end = piece.end;
+		else
+			pieces.push_back(piece);
+	}
+	refs = pieces;
+}
+
+// Index of the last entry starting at or before address, or -1.
+static int intervalFloor(const vector<IntervalRef> &refs, uint64_t address)
+{
+	IntervalRef key;
+	key.start = address;
+	return (int)(upper_bound(refs.begin(), refs.end(), key) - refs.begin()) - 1;
+}
+
+// Lowest order of the entries containing address (ends are inclusive), or -1.
+static int intervalSearch(const vector<IntervalRef> &refs, uint64_t address)
+{
+	int k = intervalFloor(refs, address);
+	return k >= 0 && refs[k].end >= address ? refs[k].order : -1;
+}
+
+// Host reservation for a 32-bit guest, see MMU::mapArena.
+#define ARENA_SIZE (1ULL << 32)
+
 using namespace std;
 
 #define R 4
@@ -31,6 +135,28 @@ using namespace std;
 #define GUARDPAGE_MEMORY_CONST     0b010
 #define FREED_MEMORY_CONS          0b100
 
+// Resource limits, see MMU::checkLimits. limitHit holds the first one exceeded.
+#define LIMIT_NONE  0
+#define LIMIT_HEAP  1
+#define LIMIT_STACK 2
+#define LIMIT_DIRTY 3
+#define LIMIT_RSS   4
+#define RSS_CHECK_INTERVAL 256 // Limit checks between reads of the host RSS
+const char *limitNames[] = {"none", "heap", "stack", "dirty pages", "host RSS"};
+
+// Heap and stack bytes, dirty pages (as listed by MMU::forEachDirty) and host resident
+// bytes. Used both for the caps of an MMU, where 0 is no limit, and for what it uses.
+struct ResourceCounters
+{
+	uint64_t heapBytes = 0;
+	uint64_t stackBytes = 0;
+	uint64_t dirtyPages = 0;
+	uint64_t rssBytes = 0;
+};
+
+// Caps every MMU starts with, set from the command line.
+ResourceCounters defaultLimits;
+
 //const short int IntegerOverflow = 1;
 //const short int MemoryFault = 2;
 
@@ -53,6 +179,7 @@ section::section(int start, int length, char permissions, int width, char *name,
 	}
 	this->initialized = (bool*)calloc(depth, sizeof(bool));
 	this->writtenTo = (bool*)calloc(depth, sizeof(bool));
+	this->image = NULL;
 	ID = 0;
 
 	this->parent = (segment *)malloc(sizeof(segment));
@@ -84,6 +211,181 @@ struct Allocation
 
 void generallyPause();
 
+// Guest memory is big endian, these swap a host value to or from it.
+static inline uint8_t bigEndian(uint8_t value) { return value; }
+static inline uint16_t bigEndian(uint16_t value) { return __builtin_bswap16(value); }
+static inline uint32_t bigEndian(uint32_t value) { return __builtin_bswap32(value); }
+static inline uint64_t bigEndian(uint64_t value) { return __builtin_bswap64(value); }
+
+// Arena of the MMU that installed the SIGSEGV handler, so host faults inside it can be told
+// apart from faults in the emulator itself. A guest access that faults in the arena jumps
+// to arenaFaultJump, set by the CPU around instruction dispatch, with the guest address in
+// arenaFaultAddress. Anything else goes to the handler that was installed before.
+static char *faultArena = NULL;
+static sigjmp_buf *arenaFaultJump = NULL;
+static volatile uint64_t arenaFaultAddress = 0;
+static struct sigaction previousFaultAction;
+static bool faultHandlerInstalled = false;
+
+static void arenaFaultHandler(int sig, siginfo_t *info, void *context)
+{
+	char *address = (char *) info->si_addr;
+	if (faultArena != NULL && arenaFaultJump != NULL && address >= faultArena && address < faultArena + ARENA_SIZE)
+	{
+		arenaFaultAddress = address - faultArena;
+		siglongjmp(*arenaFaultJump, 1);
+	}
+	if (previousFaultAction.sa_flags & SA_SIGINFO)
+		previousFaultAction.sa_sigaction(sig, info, context);
+	else if (previousFaultAction.sa_handler != SIG_DFL && previousFaultAction.sa_handler != SIG_IGN)
+		previousFaultAction.sa_handler(sig);
+	else
+	{
+		// Returning retries the access, which then crashes as usual
+		struct sigaction fallback;
+		memset(&fallback, 0, sizeof(fallback));
+		fallback.sa_handler = SIG_DFL;
+		sigaction(SIGSEGV, &fallback, NULL);
+	}
+}
+
+// The loaded sections of a binary, kept in a file at their guest addresses and shared by
+// every MMU emulating that binary, see MMU::openSharedImage. path is empty for an image
+// only this process can see.
+struct SharedImage
+{
+	int fd;
+	int users;
+	string path;
+};
+static unordered_map<BinaryView *, SharedImage> sharedImages;
+
+// Where images are shared between processes. A tmpfs, so the pages the processes map from
+// an image are memory they have in common.
+#define SHARED_IMAGE_DIR "/dev/shm"
+
+// One TLB entry. It maps the guest range [lo, hi) straight to host memory, which the slow
+// path would have resolved to the same place for every address in it.
+struct TLBEntry
+{
+	uint64_t lo = 0;
+	uint64_t hi = 0; // lo == hi is an empty entry
+	intptr_t offset = 0;
+	bool executable = false;
+};
+
+// Guest bytes as they were when a snapshot was taken, saved the first time they are written
+// after it. host is where they go back on restore.
+struct SavedRange
+{
+	char *host;
+	vector<char> bytes;
+};
+
+// A heap page as it was when a snapshot was taken. Heap memory lives in vectors that move as
+// they grow, so it is kept by index rather than by host address.
+struct SavedHeapPage
+{
+	uint64_t index;
+	vector<uint8_t> backing;
+	vector<uint8_t> initialized;
+};
+
+// Core files, see EmulatedCPU::writeCore. After the CoreHeader and the registers come the
+// memory regions, each a CoreRegion followed by its non-zero pages as CoreChunks and closed
+// by an empty chunk. Read-only sections are recorded by extent only, their bytes are the
+// binary's. The heap region holds the heap's bytes, shadow bytes and allocations instead.
+#define CORE_MAGIC 0x45524f4353504d4dULL
+#define CORE_VERSION 2
+#define CORE_END 0
+#define CORE_SECTION 1
+#define CORE_STACK 2
+#define CORE_HEAP 3
+
+struct CoreHeader
+{
+	uint64_t magic;
+	uint32_t version;
+	uint32_t is64bit;
+	uint64_t entryPoint; // Of the binary the core was written from,
+	uint64_t layout;     // and MMU::layoutHash of its sections
+};
+
+struct CoreRegion
+{
+	uint64_t start;
+	uint64_t length;
+	uint32_t kind;
+	uint32_t permissions; // R, W and X
+};
+
+struct CoreChunk
+{
+	uint64_t address;
+	uint64_t length; // 0 ends the region
+};
+
+struct CoreAllocation
+{
+	uint64_t address;
+	uint64_t pc;
+	uint32_t size;
+	uint32_t isFree;
+};
+
+// Writes the non-zero TLB pages of [address, address + length), held at host, as chunks.
+static void writeCoreChunks(FILE *fp, uint64_t address, const char *host, uint64_t length)
+{
+	static const char zeros[TLB_PAGE_SIZE] = {0};
+	while (length > 0)
+	{
+		uint64_t piece = min(length, (uint64_t)TLB_PAGE_SIZE - (address & (TLB_PAGE_SIZE - 1)));
+		if (memcmp(host, zeros, piece) != 0)
+		{
+			CoreChunk chunk = {address, piece};
+			fwrite(&chunk, sizeof(chunk), 1, fp);
+			fwrite(host, 1, piece, fp);
+		}
+		address += piece;
+		host += piece;
+		length -= piece;
+	}
+}
+
+static void endCoreRegion(FILE *fp)
+{
+	CoreChunk chunk = {0, 0};
+	fwrite(&chunk, sizeof(chunk), 1, fp);
+}
+
+// Reads the chunks of region up to its empty one and hands each to store(address, bytes,
+// length). False on a short read or a chunk outside the region.
+template <class F>
+static bool readCoreChunks(FILE *fp, const CoreRegion &region, F store)
+{
+	char bytes[TLB_PAGE_SIZE];
+	CoreChunk chunk;
+	while (fread(&chunk, sizeof(chunk), 1, fp) == 1)
+	{
+		if (chunk.length == 0)
+			return true;
+		if (chunk.length > TLB_PAGE_SIZE || chunk.address < region.start || chunk.address + chunk.length > region.start + region.length)
+			return false;
+		if (fread(bytes, 1, chunk.length, fp) != chunk.length)
+			return false;
+		store(chunk.address, bytes, chunk.length);
+	}
+	return false;
+}
+
+// One guest page in the MMU page table.
+struct PageEntry
+{
+	section *owner = NULL; // The only section on the page
+	bool shared = false; // Several sections touch the page, so they are searched instead
+	uint8_t kinds = 0; // REGION_ bits of every region touching the page
+};
+
 class Heap
 {
 	private:
@@ -94,6 +396,50 @@ class Heap
 		std::vector<uint8_t> initializedMemory;
 		std::unordered_map<uint32_t, Allocation> allocInfo; // uint32_t here is the virtual address.
 		char *outputfile;
+		bool allocationRefused = false; // The last allocMem did not fit under maxHeapSize
+
+		// Snapshot state, see snapshot(). Pages of the heap are saved the first time they
+		// change after it, and allocations made since are remembered so restore can drop them.
+		bool snapshotTaken = false;
+		uint64_t snapshotHeapSize = 0;
+		std::unordered_set<uint64_t> journaledPages;
+		std::vector<SavedHeapPage> heapJournal;
+		std::vector<uint32_t> allocationsSinceSnapshot;
+
+		// TLB_PAGE_SIZE pages of the heap changed since clearDirty(), by heap index.
+		std::vector<bool> dirtyPages;
+		uint64_t dirtyCount = 0;
+
+		void markDirty(uint64_t index, uint64_t size)
+		{
+			if(size == 0)
+				return;
+			uint64_t last = (index + size - 1) >> TLB_PAGE_SHIFT;
+			if(last >= dirtyPages.size())
+				dirtyPages.resize(last + 1, false);
+			for(uint64_t page = index >> TLB_PAGE_SHIFT; page <= last; page++)
+			{
+				dirtyCount += !dirtyPages[page];
+				dirtyPages[page] = true;
+			}
+		}
+
+		// Saves the TLB_PAGE_SIZE pages of the heap under [index, index + size) the first time
+		// they change after the snapshot. Anything past the snapshot heap is dropped on restore.
+		void journal(uint64_t index, uint64_t size)
+		{
+			if(!snapshotTaken || size == 0)
+				return;
+			for(uint64_t page = index >> TLB_PAGE_SHIFT; page <= (index + size - 1) >> TLB_PAGE_SHIFT; page++)
+			{
+				uint64_t lo = page << TLB_PAGE_SHIFT;
+				uint64_t hi = min(lo + TLB_PAGE_SIZE, snapshotHeapSize);
+				if(lo >= hi || !journaledPages.insert(page).second)
+					continue;
+				heapJournal.push_back({lo, vector<uint8_t>(backingMemory.begin() + lo, backingMemory.begin() + hi),
+					vector<uint8_t>(initializedMemory.begin() + lo, initializedMemory.begin() + hi)});
+			}
+		}
 	
 	public:
 		
@@ -102,7 +448,7 @@ class Heap
 		// size for the heap from the emulator based off of layout of program memory.
 		// Example call heap(0x5fffffff, 0xffffff);
 		
-		Heap(uint64_t HeapBase, uint64_t MaxHeapSize, char *fp)
+		Heap(uint64_t HeapBase, uint64_t MaxHeapSize, char *fp, uint64_t Reserve = MAX_HEAP_SIZE)
 		{
 			outputfile = fp;
 			if(fp == NULL)
@@ -112,6 +458,10 @@ class Heap
 			this->heapBase = HeapBase;
 			this->maxHeapSize = MaxHeapSize;
 			this->heapSize = 0;
+			// Only the first Reserve bytes are reserved up front, a heap growing past them just
+			// reallocates. Nothing keeps a host pointer into the heap across an allocMem.
+			backingMemory.reserve(min(Reserve, MaxHeapSize));
+			initializedMemory.reserve(min(Reserve, MaxHeapSize));
 		}
 
 		Heap()
@@ -124,18 +474,119 @@ class Heap
 			backingMemory.clear();
 			initializedMemory.clear();
 			allocInfo.clear();
+			dirtyPages.clear();
+			dirtyCount = 0;
+			discardSnapshot();
+		}
+
+		// Calls visit(address, length) for each heap page changed since clearDirty().
+		template <class F>
+		void forEachDirty(F visit)
+		{
+			for(uint64_t page = 0; page < dirtyPages.size(); page++)
+			{
+				uint64_t lo = page << TLB_PAGE_SHIFT;
+				if(dirtyPages[page] && lo < heapSize)
+					visit(heapBase + lo, min((uint64_t) TLB_PAGE_SIZE, heapSize - lo));
+			}
+		}
+
+		void clearDirty()
+		{
+			dirtyPages.assign(dirtyPages.size(), false);
+			dirtyCount = 0;
+		}
+
+		// The heap region of a core file: its bytes, their shadow and the allocations.
+		void writeCore(FILE *fp)
+		{
+			CoreRegion region = {heapBase, heapSize, CORE_HEAP, R | W};
+			fwrite(&region, sizeof(region), 1, fp);
+			fwrite(backingMemory.data(), 1, heapSize, fp);
+			fwrite(initializedMemory.data(), 1, heapSize, fp);
+			uint64_t count = allocInfo.size();
+			fwrite(&count, sizeof(count), 1, fp);
+			for(auto &entry : allocInfo)
+			{
+				CoreAllocation allocation = {entry.first, entry.second.pc, entry.second.size, entry.second.isFree};
+				fwrite(&allocation, sizeof(allocation), 1, fp);
+			}
+		}
+
+		bool readCore(FILE *fp, const CoreRegion &region)
+		{
+			if(region.start != heapBase || region.length > maxHeapSize)
+				return false;
+			backingMemory.resize(region.length);
+			initializedMemory.resize(region.length);
+			if(fread(backingMemory.data(), 1, region.length, fp) != region.length
+				|| fread(initializedMemory.data(), 1, region.length, fp) != region.length)
+				return false;
+			heapSize = region.length;
+			uint64_t count;
+			if(fread(&count, sizeof(count), 1, fp) != 1)
+				return false;
+			allocInfo.clear();
+			for(uint64_t i = 0; i < count; i++)
+			{
+				CoreAllocation allocation;
+				if(fread(&allocation, sizeof(allocation), 1, fp) != 1)
+					return false;
+				allocInfo[allocation.address] = {allocation.size, allocation.isFree != 0, allocation.pc};
+			}
+			discardSnapshot();
+			dirtyPages.clear();
+			dirtyCount = 0;
+			return true;
+		}
+
+		// Marks the current heap as the one restore() goes back to.
+		void snapshot()
+		{
+			discardSnapshot();
+			snapshotTaken = true;
+			snapshotHeapSize = heapSize;
+		}
+
+		// Puts back the pages changed since snapshot() and forgets later allocations.
+		bool restore()
+		{
+			if(!snapshotTaken)
+				return false;
+			backingMemory.resize(snapshotHeapSize);
+			initializedMemory.resize(snapshotHeapSize);
+			heapSize = snapshotHeapSize;
+			for(SavedHeapPage &saved : heapJournal)
+			{
+				copy(saved.backing.begin(), saved.backing.end(), backingMemory.begin() + saved.index);
+				copy(saved.initialized.begin(), saved.initialized.end(), initializedMemory.begin() + saved.index);
+			}
+			for(uint32_t address : allocationsSinceSnapshot)
+				allocInfo.erase(address);
+			journaledPages.clear();
+			heapJournal.clear();
+			allocationsSinceSnapshot.clear();
+			allocationRefused = false;
+			return true;
+		}
+
+		void discardSnapshot()
+		{
+			snapshotTaken = false;
+			journaledPages.clear();
+			heapJournal.clear();
+			allocationsSinceSnapshot.clear();
 		}
 		
 		// This is essentially the wrapper for the memory.
 		uint32_t allocMem(uint32_t size, bool suppress = false)
 		{
-			int i;
-
 			// This is implementation specific, however, we return a NULL pntr.
 			if(size == 0)
 				return 0;
 		
-			if((this->heapSize + size) > this->maxHeapSize)
+			allocationRefused = (this->heapSize + size + 2 * GUARD_PAGE_LENGTH) > this->maxHeapSize;
+			if(allocationRefused)
 			{
 				printf("[ERROR] Our heap has exceeded the maximum size.\n");
 				if(outputfile != NULL)
@@ -149,43 +600,31 @@ class Heap
 				return 0;
 			}
 		
-			// Get the size of two guard pages.
-			for(i = 0; i < GUARD_PAGE_LENGTH; i++)
+			// Bump the heap by the body and its two guard pages in one go, the shadow marks
+			// the body uninitialized and the guards as guard pages.
+			uint64_t index = this->heapSize;
+			uint64_t total = GUARD_PAGE_LENGTH + size + GUARD_PAGE_LENGTH;
+			this->backingMemory.resize(index + total, 0);
+			this->initializedMemory.resize(index + total, UNINITIALIZED_MEMORY_CONST);
+			for(uint64_t guard : {index, index + GUARD_PAGE_LENGTH + size})
 			{
-				if(!suppress)
-					printf("Guard Page 1: vaddr: [0x%lx] and index [%d].\n", this->heapBase + heapSize, i);
-				this->backingMemory.push_back(GUARD_PAGE_VAL);
-				this->initializedMemory.push_back(GUARDPAGE_MEMORY_CONST);
-				this->heapSize++;
+				fill_n(this->backingMemory.begin() + guard, GUARD_PAGE_LENGTH, GUARD_PAGE_VAL);
+				fill_n(this->initializedMemory.begin() + guard, GUARD_PAGE_LENGTH, GUARDPAGE_MEMORY_CONST);
 			}
-			
+			this->heapSize += total;
+
+			uint32_t toReturn = this->heapBase + index + GUARD_PAGE_LENGTH;
+			if(!suppress)
+				printf("Allocated: vaddr: [0x%x] size [%u] between guard pages at [0x%lx] and [0x%lx].\n", toReturn, size,
+				       this->heapBase + index, this->heapBase + index + GUARD_PAGE_LENGTH + size);
+
 			// Get the current value right now of the memory we're at.
 			Allocation newAllocationInfo =  {size, 0, 0xfff}; // TODO: Implement PC
-			allocInfo[(this->heapSize + this->heapBase)] = newAllocationInfo;
-			
-			uint32_t toReturn = (this->heapSize + this->heapBase);
-			
-			for(; i < size + GUARD_PAGE_LENGTH; i++)
-			{
-				if(!suppress)
-					printf("Normal Memory: vaddr: [0x%lx] and index [%d].\n", this->heapBase + heapSize, i);
-				this->backingMemory.push_back(0);
-				this->initializedMemory.push_back(UNINITIALIZED_MEMORY_CONST);
-				this->heapSize++;
-			}
-			
-			
-			// Get the size of the second guard page.
-			for(; i < GUARD_PAGE_LENGTH + size + GUARD_PAGE_LENGTH; i++)
-			{
-				if(!suppress)
-					printf("Guard Page 2: vaddr: [0x%lx] and index [%d].\n", this->heapBase + heapSize, i);
-				this->backingMemory.push_back(GUARD_PAGE_VAL);
-				this->initializedMemory.push_back(GUARDPAGE_MEMORY_CONST);
-				this->heapSize++;
-			}
+			allocInfo[toReturn] = newAllocationInfo;
+			if(snapshotTaken)
+				allocationsSinceSnapshot.push_back(toReturn);
 			
-			// This is unsafe to use after alloc.
+			markDirty(toReturn - this->heapBase - GUARD_PAGE_LENGTH, size + 2 * GUARD_PAGE_LENGTH);
 			return (uint32_t) toReturn;
 		}
 		
@@ -378,6 +817,7 @@ class Heap
 			
 			start = max((uint64_t) vaddr - 32, heapBase); 
 			end = min((uint64_t) 32 + vaddr, heapSize);
+			journal(vaddr - this->heapBase, size);
 			for(i = (vaddr - this->heapBase); i < ((vaddr - this->heapBase) + size); i++ )
 			{
 				//printf("Checking for guard pages and such at index i:[%d] and vaddr_base [0x%lx] and vaddr [0x%x].\n", i, (vaddr-this->heapBase), (i));
@@ -400,6 +840,7 @@ class Heap
 				
 				this->initializedMemory[i] = 0;
 			}
+			markDirty(vaddr - this->heapBase, size);
 			//printf("Heap pass:\n");
 			//fflush(stdout);
 		
@@ -479,6 +920,8 @@ class Heap
 			
 			for(i = index; (!(this->initializedMemory[i] & GUARDPAGE_MEMORY_CONST)); i++)
 			{
+				journal(i, 1);
+				markDirty(i, 1);
 				this->initializedMemory[i] = FREED_MEMORY_CONS;
 			}
 			
@@ -486,6 +929,38 @@ class Heap
 			
 		}
 
+		uint64_t getHeapBase()
+		{
+			return heapBase;
+		}
+
+		uint64_t getHeapSize()
+		{
+			return heapSize;
+		}
+
+		uint64_t getMaxHeapSize()
+		{
+			return maxHeapSize;
+		}
+
+		uint64_t getDirtyCount()
+		{
+			return dirtyCount;
+		}
+
+		bool lastAllocationRefused()
+		{
+			return allocationRefused;
+		}
+
+		// Raw byte at vaddr without the guard page or initialization checks, for scanning
+		// ahead of a checked read of the bytes actually used.
+		uint8_t* peekHeapMemory(uint32_t vaddr)
+		{
+			return &backingMemory[vaddr - this->heapBase];
+		}
+
 		bool isInHeap(uint32_t vaddr)
 		{
 			// Make sure we're accessing something larger then the heap base
@@ -687,7 +1162,9 @@ class MMU
 	
 	vector<segment> segments;
 	vector<section> allSections;
-	vector<char> stack;
+	char *stackTop = NULL; // Host address of stackBase, the stack runs up to it in address order
+	char *stackMapping = NULL; // Own mapping for the stack when there is no arena
+	uint64_t stackSize; // Bytes below stackBase the program has reached
 	Heap MMUHeap;
 	uint64_t GOTpointer;
 	uint64_t stackBase;
@@ -700,6 +1177,45 @@ class MMU
 	vector<uint64_t> stackPointerSections;
 	vector<uint64_t> framePointerSections;
 
+	// Split read, write and execute TLBs. Anything that moves host memory or changes what an
+	// address resolves to (stack growth, heap growth, permission changes) must call flushTLB.
+	TLBEntry readTLB[TLB_ENTRIES];
+	TLBEntry writeTLB[TLB_ENTRIES];
+	TLBEntry execTLB[TLB_ENTRIES];
+	uint64_t tlbHeapSize = 0;
+
+	// Page tables for the binary image, allocated only where it has sections.
+	vector<PageEntry *> pageDirectory;
+
+	// Interval indexes for segSearch and findSection. sectionOrder lists the sections in
+	// the order findSection's search visits them.
+	vector<IntervalRef> segmentIndex;
+	vector<IntervalRef> sectionIndex;
+	vector<section *> sectionOrder;
+
+	// Guest address space reservation holding the writable sections, NULL when not mapped.
+	char *arena = NULL;
+	// memfd the arena's sections are mapped from, -1 when they were read in directly.
+	int sharedImage = -1;
+
+	// Snapshot state, see snapshot(). journal holds the stack and writable section bytes of
+	// every TLB page written since, journaledPages the page numbers already in it.
+	bool snapshotTaken = false;
+	uint64_t snapshotStackSize = 0;
+	unordered_set<uint64_t> journaledPages;
+	vector<SavedRange> journal;
+
+	// TLB pages of the stack written since clearDirty(), from the lowest stack page up.
+	// Sections keep theirs per block in section::writtenTo, the heap in Heap::dirtyPages.
+	// dirtyCount counts the stack pages and section blocks among them.
+	vector<bool> stackDirty;
+	uint64_t dirtyCount = 0;
+
+	// Resource caps of this MMU, see checkLimits.
+	ResourceCounters limits = defaultLimits;
+	int limitHit = LIMIT_NONE;
+	uint64_t limitChecks = 0;
+
 	MMU(bool is64bit, BinaryView* bc, uint64_t stackBase=0, char *fp = NULL)
 	{	
 		
@@ -728,6 +1244,7 @@ class MMU
 
 			segments[i].sections = new vector<section>();
 		}
+		buildSegmentIndex();
 		auto sectionlist = bv->GetSections();
 		allSections = vector<section>();
 		char *secName;
@@ -760,12 +1277,20 @@ class MMU
 			//couple segment and section
 			allSections[i].parent->sections->push_back(allSections[i]);
 		}
+		if(!is64Bit)
+			mapArena();
+		loadImage();
+		buildSectionIndex();
+		buildPageTable();
 
 		//Allocate the stack
-		this->stack = vector<char>(5);
 		gap bigGap = getLargestGap();
 		this->stackBase = bigGap.r - 0xf;
 		this->stackMaxLength = bigGap.r - 0xfff - bigGap.l;
+		this->stackSize = 5;
+		mapRegion(this->stackBase - this->stackMaxLength + 1, this->stackBase, REGION_STACK);
+		mapRegion(this->stackBase + 1, this->stackBase + 16, REGION_GUARD);
+		mapStack();
 		//Fill with fuzzing dataf
 		
 		//printf("0x%llx, 0x%llx\n", stackBase-20, this->stackBase);
@@ -786,7 +1311,7 @@ class MMU
 			data[i] = 0;
 		data[0] = 1;
 		stackWrite(this->stackBase - 28 - 396, data, 4);
-		this->stack.resize(500);
+		this->stackSize = max(stackSize, (uint64_t)500);
 
 		//Allocate the heap
 		bool *excluded = (bool *)calloc(allSections.size() + 1, sizeof(bool));
@@ -799,7 +1324,13 @@ class MMU
 		//printf("%x, %x gap right sides\n", bigGap.r, secondBiggestGap.r);
 		//printf("%x, %x gap right section\n", bigGap.rightSection, secondBiggestGap.rightSection);
 		//Left and right bounds of SBG padded by 8 bytes
-		MMUHeap = Heap(secondBiggestGap.l + 8, secondBiggestGap.r - secondBiggestGap.r -16, outputfile);
+		uint64_t maxHeapSize = secondBiggestGap.r - secondBiggestGap.l - 16;
+		if(limits.heapBytes != 0)
+			maxHeapSize = min(maxHeapSize, limits.heapBytes);
+		// A heap limit is what the program is expected to use, so reserve all of it
+		MMUHeap = Heap(secondBiggestGap.l + 8, maxHeapSize, outputfile, limits.heapBytes != 0 ? maxHeapSize : MAX_HEAP_SIZE);
+		mapRegion(MMUHeap.getHeapBase(), MMUHeap.getHeapBase() + maxHeapSize, REGION_HEAP);
+		flushTLB();
 
 		//uint32_t GOTbase = MMUHeap.allocMem(65536);
 		//GOTpointer = GOTbase + 32768;
@@ -811,8 +1342,14 @@ class MMU
 	void MMUFree()
 	{
 		//Take care of the binary
+		freeImages();
+		freePageTable();
+		unmapArena();
 		segments.clear();
 		allSections.clear();
+		segmentIndex.clear();
+		sectionIndex.clear();
+		sectionOrder.clear();
 		
 
 		//Take care of the heap
@@ -820,167 +1357,696 @@ class MMU
 		
 
 		//Break the stack's knees
-		stack.clear();
+		if(stackMapping != NULL)
+			munmap(stackMapping, stackMaxLength + 16);
+		stackMapping = NULL;
+		stackTop = NULL;
+		stackDirty.clear();
+		dirtyCount = 0;
+		discardSnapshot();
+		flushTLB();
 	}
 
-	
-	void secSort()
+	// Reserves the whole 32-bit guest space on the host and moves the writable sections'
+	// blocks into it at their guest addresses. The rest of the reservation stays PROT_NONE,
+	// so an access that runs off a section faults, and arenaFaultHandler turns it into a
+	// guest memory fault. Blocks are loaded up front, since a lazily loaded block would
+	// overwrite a neighbouring section the guest may already have written. They come from
+	// the shared image when there is one, and are only read from the BinaryView otherwise.
+	void mapArena()
 	{
-		vector<section> sorted = vector<section>();
-		bool *disabled = (bool *)calloc(allSections.size(), sizeof(bool));
-		section least;
-		int leastIndex;
+		void *region = mmap(NULL, ARENA_SIZE, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (region == MAP_FAILED)
+		{
+			// Keep the separately allocated blocks
+			return;
+		}
+		arena = (char *) region;
+		sharedImage = openSharedImage();
 
-		fflush(stdout);
-		for (int j = 0;j < allSections.size();j++)
+		for (int i = 0;i < segments.size();i++)
 		{
-			
-			least = section(0xffffffffffffffff);
-			
-			for (int i = 0;i < allSections.size();i++)
+			for (int j = 0;j < segments[i].sections->size();j++)
 			{
-				if (allSections[i] < least && !disabled[i])
+				section &token = (*segments[i].sections)[j];
+				if (!token.readable || !token.writable || token.end >> 32 != 0)
+					continue;
+				int depth = (token.length / token.width) + 1;
+				uint64_t length = (uint64_t)depth * token.width;
+				if (!mapFromImage(token.start, length))
+				{
+					uint64_t first = token.start & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+					uint64_t last = (token.start + length + (1 << PAGE_SHIFT) - 1) & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+					if (last > ARENA_SIZE || mprotect(arena + first, last - first, PROT_READ | PROT_WRITE) != 0)
+						continue;
+					bv->Read(arena + token.start, token.start, length);
+				}
+				for (int k = 0;k < depth;k++)
 				{
-					least = allSections[i];
-					leastIndex = i;
+					free(token.array[k]);
+					token.array[k] = arena + token.start + (uint64_t)k * token.width;
+					token.initialized[k] = true;
 				}
 			}
-			sorted.push_back(least);
-			disabled[leastIndex] = true;
-
 		}
-		for (int i = 1;i < allSections.size();i++)
+
+		// Installed once, so the handler saved is never this one
+		if (!faultHandlerInstalled)
 		{
-			allSections = sorted;
+			struct sigaction action;
+			memset(&action, 0, sizeof(action));
+			action.sa_sigaction = arenaFaultHandler;
+			action.sa_flags = SA_SIGINFO | SA_ONSTACK;
+			sigemptyset(&action.sa_mask);
+			faultHandlerInstalled = sigaction(SIGSEGV, &action, &previousFaultAction) == 0;
 		}
-		free(disabled);
-		return;
-			
+		faultArena = arena;
 	}
-	
 
-	
-	segment segSearch(uint64_t index)
+	// Reports a guest access that faulted in the arena, once arenaFaultHandler has jumped
+	// back out of the signal handler.
+	void reportArenaFault(uint64_t address)
 	{
-		for (int i = 0;i < segments.size();i++)
+		printf("Memory Fault Exception at 0x%lx\n", address);
+		if(outputfile != NULL)
 		{
-			if (index <= segments[i].end && index >= segments[i].start)
-			{
-				return segments[i];
-			}
+			FILE *file = fopen(outputfile, "a");
+			fprintf(file, "Memory Fault Exception at 0x%lx\n", address);
+			fclose(file);
 		}
-		return segment();
 	}
 
-	//calculates the largest gap between sections
-	//returns the left and right border of the gap
-	gap getLargestGap(bool * excluded = NULL)
+	// Returns a file holding every loaded section of the binary at its guest address. The
+	// file is named after a hash of the binary's sections and their contents, so every
+	// emulator process on the same binary opens the same one, and only the first builds it.
+	// Instances map it MAP_PRIVATE, so they share the pages they only read and each owns
+	// just the pages it writes, instead of every instance reading the whole binary into
+	// memory of its own. Without SHARED_IMAGE_DIR the image is a memfd, shared only inside
+	// this process. -1 if neither is available.
+	int openSharedImage()
 	{
-		
-		if(excluded == NULL)
-		{
-			excluded = (bool *) calloc(allSections.size() + 1, sizeof(bool));
-		}
-		
-		int l=0,r=0;
-		int maxl=0,maxr=0, maxWidth = 0, maxI = 0;
-		
-		for(int i=0;i<allSections.size();i++)
+		auto found = sharedImages.find(bv);
+		if (found != sharedImages.end())
 		{
-			
-			r = allSections[i].start;
-			if(r-l > maxWidth && !excluded[i])
-			{
-				maxWidth = r - l;
-				maxr = r;
-				maxl = l;
-				maxI = i;
-			}
-
-			l = allSections[i].end;
-			
+			found->second.users++;
+			return found->second.fd;
 		}
-		fflush(stdout);
-		r = 0x7fffffff;
-		if(r - l > maxWidth && !excluded[allSections.size()])
+		char path[64];
+		snprintf(path, sizeof(path), SHARED_IMAGE_DIR "/mips-image-%016lx", imageHash());
+		int fd = open(path, O_RDONLY | O_CLOEXEC);
+		struct stat info;
+		// Only trust an image this user built in full, see buildSharedImage
+		if (fd >= 0 && (fstat(fd, &info) != 0 || info.st_uid != geteuid() || info.st_size != ARENA_SIZE))
 		{
-			maxWidth = r - l;
-			maxr = r;
-			maxl = l;
-			maxI = allSections.size();
+			close(fd);
+			fd = -1;
 		}
-		gap out;
-
-		out.l = maxl;
-		out.r = maxr;
-		out.rightSection = maxI;
-		fflush(stdout);
-		free(excluded);
-		return out;
+		if (fd < 0)
+			fd = buildSharedImage(path);
+		if (fd < 0)
+			return -1;
+		// Every process mapping the image holds a shared lock on it, see closeSharedImage
+		flock(fd, LOCK_SH);
+		sharedImages[bv] = {fd, 1, path};
+		return fd;
 	}
 
-	//Writes to the stack in increasing memory index (the emulated stack is backwards)
-	//^No it doesn't, that's dumb
-	//Writes to the stack in increasing memory address. 
-	void stackWrite(uint64_t address, char *data, int length)
+	// Writes the image under a name of this process's own and renames it to path once it is
+	// complete, so another process never opens a partial image. Falls back to a memfd, and
+	// clears path, when the file cannot be created.
+	int buildSharedImage(char *path)
 	{
-		fflush(stdout);
-		if(stackBase - address + 1 > stack.size())
+		char building[80];
+		snprintf(building, sizeof(building), "%s.%d", path, getpid());
+		int fd = open(building, O_RDWR | O_CREAT | O_EXCL | O_CLOEXEC, 0600);
+		if (fd < 0)
 		{
-			stack.resize(stackBase - address + 1);
+			building[0] = '\0';
+			path[0] = '\0';
+			fd = memfd_create("guest-image", 0);
+			if (fd < 0)
+				return -1;
 		}
-		int startingIndex = stackBase-address;
-		for(int i = startingIndex;i > startingIndex - length; i--)
+		void *region = MAP_FAILED;
+		if (ftruncate(fd, ARENA_SIZE) == 0)
+			region = mmap(NULL, ARENA_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_NORESERVE, fd, 0);
+		if (region == MAP_FAILED)
 		{
-			stack[i] = data[i - startingIndex + length - 1];
-		}
-		return;
-	}
-	
-	bool isInStack(uint64_t address, bool expandStack = true)
-	{
-		//printf("stack check address: %x, stackBase %x, stackmaxlength %x", address, stackBase, stackMaxLength);
-		if(expandStack == true && address <= stackBase && address > stackBase - stackMaxLength)
-		{
-			return true;
+			close(fd);
+			if (building[0] != '\0')
+				unlink(building);
+			return -1;
 		}
-		if(expandStack == false && address <= stackBase && address > stackBase - stack.size())
+		char *image = (char *) region;
+		forEachImageRead([&](uint64_t start, uint64_t length) {
+			bv->Read(image + start, start, length);
+		});
+		munmap(region, ARENA_SIZE);
+		// Losing a race to another process only means this one keeps an image of its own
+		if (building[0] != '\0' && rename(building, path) != 0)
 		{
-			return true;
+			unlink(building);
+			path[0] = '\0';
 		}
-		return false;
+		return fd;
 	}
-	
-	bool isInBinary(uint64_t address)
+
+	// Calls read(start, length) for each range of the binary the image holds: the same reads,
+	// in the same order, mapArena and loadImage make without an image.
+	template <class F>
+	void forEachImageRead(F read)
 	{
-		//For Binja binary accesses	
-		//For each segment,
 		for (int i = 0;i < segments.size();i++)
 		{
-			//For each section,
 			for (int j = 0;j < segments[i].sections->size();j++)
 			{
-				segment tokenHold = segments[i];
-				section token = (*(tokenHold.sections))[j];
-				//Is it valid? (within bounds)
-				if (address >= token.start && address <= token.end)
-				{
-					return true;
-				}
+				section &token = (*segments[i].sections)[j];
+				uint64_t length = (uint64_t)((token.length / token.width) + 1) * token.width;
+				if (token.readable && token.writable && token.start + length <= ARENA_SIZE)
+					read(token.start, length);
+			}
+		}
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section &token = (*segments[i].sections)[j];
+				if (token.readable && !token.writable && token.start + token.length + 1 <= ARENA_SIZE)
+					read(token.start, token.length + 1);
 			}
 		}
-		return false;
+	}
+
+	// FNV-1a hash of where the image's ranges lie and the bytes in them, which names the
+	// shared image of this binary.
+	uint64_t imageHash()
+	{
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		auto mix = [&](const char *bytes, uint64_t length) {
+			for (uint64_t i = 0;i < length;i++)
+			{
+				hash ^= (uint8_t)bytes[i];
+				hash *= 0x100000001b3ULL;
+			}
+		};
+		vector<char> bytes;
+		forEachImageRead([&](uint64_t start, uint64_t length) {
+			mix((const char *)&start, sizeof(start));
+			mix((const char *)&length, sizeof(length));
+			bytes.assign(length, 0);
+			bv->Read(bytes.data(), start, length);
+			mix(bytes.data(), length);
+		});
+		return hash;
+	}
+
+	void closeSharedImage()
+	{
+		if (sharedImage < 0)
+			return;
+		auto found = sharedImages.find(bv);
+		if (found != sharedImages.end() && found->second.fd == sharedImage && --found->second.users == 0)
+		{
+			// The last process holding the image removes its name. Any process that opened it
+			// meanwhile keeps a working mapping, later ones build it again. An emulator that is
+			// killed instead leaves the image behind, and the next run on the binary reuses it.
+			if (!found->second.path.empty() && flock(sharedImage, LOCK_EX | LOCK_NB) == 0)
+				unlink(found->second.path.c_str());
+			close(sharedImage);
+			sharedImages.erase(found);
+		}
+		sharedImage = -1;
+	}
+
+	// Maps the pages under [start, start + length) of the arena copy-on-write from the shared
+	// image. False if there is no image or the range does not fit.
+	bool mapFromImage(uint64_t start, uint64_t length)
+	{
+		if (sharedImage < 0)
+			return false;
+		uint64_t first = start & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+		uint64_t last = (start + length + (1 << PAGE_SHIFT) - 1) & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+		if (last > ARENA_SIZE)
+			return false;
+		return mmap(arena + first, last - first, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_FIXED, sharedImage, first) != MAP_FAILED;
+	}
+
+	// Reserves the whole stack, stackMaxLength bytes up to stackBase plus the 16 byte window
+	// above it, in address order. Pages are only committed once the program reaches them and
+	// the reservation never moves, so stack pointers stay valid as it grows. The stack sits
+	// at its guest address in the arena when there is one.
+	void mapStack()
+	{
+		uint64_t low = stackBase - stackMaxLength + 1;
+		stackDirty.assign((stackBase >> TLB_PAGE_SHIFT) - (low >> TLB_PAGE_SHIFT) + 1, false);
+		if (arena != NULL && stackBase + 16 < ARENA_SIZE)
+		{
+			uint64_t first = low & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+			uint64_t last = (stackBase + 16 + (1 << PAGE_SHIFT)) & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+			if (mprotect(arena + first, last - first, PROT_READ | PROT_WRITE) == 0)
+			{
+				stackTop = arena + stackBase;
+				return;
+			}
+		}
+		void *region = mmap(NULL, stackMaxLength + 16, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS | MAP_NORESERVE, -1, 0);
+		if (region == MAP_FAILED)
+		{
+			printf("Could not reserve 0x%lx bytes for the stack\n", stackMaxLength);
+			return;
+		}
+		stackMapping = (char *) region;
+		stackTop = stackMapping + (stackBase - low);
+	}
+
+	// Reads every read-only section once and points its image at the copy, so reads of
+	// .text and .rodata hand out pointers instead of a fresh buffer from the BinaryView.
+	// In the arena the copy sits at the section's guest address, and the pages only this
+	// section covers are then made read-only.
+	void loadImage()
+	{
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section &token = (*segments[i].sections)[j];
+				if (!token.readable || token.writable)
+					continue;
+				// The section's end byte counts as part of it
+				uint64_t length = token.length + 1;
+				char *image = NULL;
+				if (arena != NULL && token.start + length <= ARENA_SIZE)
+				{
+					uint64_t first = token.start & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+					uint64_t last = (token.start + length + (1 << PAGE_SHIFT) - 1) & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+					if (mapFromImage(token.start, length))
+						token.image = arena + token.start;
+					else if (mprotect(arena + first, last - first, PROT_READ | PROT_WRITE) == 0)
+						image = arena + token.start;
+				}
+				if (token.image != NULL)
+				{
+					// Nothing reads the blocks of a section with an image, keep none of them
+					for (int k = 0;k <= token.length / token.width;k++)
+					{
+						free(token.array[k]);
+						token.array[k] = token.image + (uint64_t)k * token.width;
+					}
+					continue;
+				}
+				if (image == NULL)
+					image = (char *) calloc(length, sizeof(char));
+				bv->Read(image, token.start, length);
+				token.image = image;
+			}
+		}
+
+		if (arena == NULL)
+			return;
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section &token = (*segments[i].sections)[j];
+				if (token.image == NULL || token.image != arena + token.start)
+					continue;
+				uint64_t first = (token.start + (1 << PAGE_SHIFT) - 1) & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+				uint64_t last = token.end & ~(uint64_t)((1 << PAGE_SHIFT) - 1);
+				if (last > first)
+					mprotect(arena + first, last - first, PROT_READ);
+			}
+		}
+	}
+
+	// Frees the read-only images loadImage had to calloc. The ones in the arena go with it.
+	void freeImages()
+	{
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section &token = (*segments[i].sections)[j];
+				if (token.image == NULL)
+					continue;
+				if (arena == NULL || token.image < arena || token.image >= arena + ARENA_SIZE)
+					free(token.image);
+				token.image = NULL;
+			}
+		}
+	}
+
+	void unmapArena()
+	{
+		if (arena == NULL)
+			return;
+		if (faultArena == arena)
+			faultArena = NULL;
+		munmap(arena, ARENA_SIZE);
+		arena = NULL;
+		closeSharedImage();
+	}
+
+	// Points every page the binary's sections touch at its section, in the order the
+	// section search visits them. An image reaching past 4 GiB is left to that search.
+	void buildPageTable()
+	{
+		pageDirectory = vector<PageEntry *>(1 << PAGE_DIRECTORY_BITS, NULL);
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section *token = &(*segments[i].sections)[j];
+				if (token->end >> 32 != 0)
+				{
+					freePageTable();
+					return;
+				}
+				for (uint64_t page = token->start >> PAGE_SHIFT; page <= token->end >> PAGE_SHIFT; page++)
+				{
+					PageEntry *&table = pageDirectory[page >> PAGE_TABLE_BITS];
+					if (table == NULL)
+						table = new PageEntry[PAGE_TABLE_SIZE];
+					PageEntry &entry = table[page & (PAGE_TABLE_SIZE - 1)];
+					if (entry.owner != NULL)
+						entry.shared = true;
+					entry.owner = token;
+					entry.kinds |= REGION_BINARY;
+				}
+			}
+		}
+	}
+
+	// Tags every page [start, end] touches with kind. The stack and heap are placed in gaps
+	// between sections once, so their pages never change afterwards. Anything past 4 GiB is
+	// left untagged, regionKinds answers every kind there.
+	void mapRegion(uint64_t start, uint64_t end, uint8_t kind)
+	{
+		end = min(end, (uint64_t)0xffffffff);
+		if (pageDirectory.empty() || start > end)
+			return;
+		for (uint64_t page = start >> PAGE_SHIFT; page <= end >> PAGE_SHIFT; page++)
+		{
+			PageEntry *&table = pageDirectory[page >> PAGE_TABLE_BITS];
+			if (table == NULL)
+				table = new PageEntry[PAGE_TABLE_SIZE];
+			table[page & (PAGE_TABLE_SIZE - 1)].kinds |= kind;
+		}
+	}
+
+	// REGION_ bits of the regions the page holding address touches. Without a page table,
+	// or past 4 GiB, every kind is possible and the range compares decide alone.
+	uint8_t regionKinds(uint64_t address)
+	{
+		if (address >> 32 != 0 || pageDirectory.empty())
+			return REGION_ALL;
+		PageEntry *table = pageDirectory[address >> (PAGE_SHIFT + PAGE_TABLE_BITS)];
+		if (table == NULL)
+			return 0;
+		return table[(address >> PAGE_SHIFT) & (PAGE_TABLE_SIZE - 1)].kinds;
+	}
+
+	void buildSegmentIndex()
+	{
+		segmentIndex = vector<IntervalRef>(segments.size());
+		for (int i = 0;i < segments.size();i++)
+		{
+			segmentIndex[i].start = segments[i].start;
+			segmentIndex[i].end = segments[i].end;
+			segmentIndex[i].order = i;
+		}
+		buildIntervalIndex(segmentIndex);
+	}
+
+	void buildSectionIndex()
+	{
+		sectionIndex.clear();
+		sectionOrder.clear();
+		for (int i = 0;i < segments.size();i++)
+		{
+			for (int j = 0;j < segments[i].sections->size();j++)
+			{
+				section *token = &(*segments[i].sections)[j];
+				IntervalRef ref;
+				ref.start = token->start;
+				ref.end = token->end;
+				ref.order = sectionOrder.size();
+				sectionIndex.push_back(ref);
+				sectionOrder.push_back(token);
+			}
+		}
+		buildIntervalIndex(sectionIndex);
+	}
+
+	void freePageTable()
+	{
+		for (int i = 0;i < pageDirectory.size();i++)
+			delete[] pageDirectory[i];
+		pageDirectory.clear();
+	}
+
+	// The section the binary access at address lands in, or NULL. One table lookup unless
+	// the page is shared between sections.
+	section *findSection(uint64_t address)
+	{
+		if (address >> 32 == 0 && !pageDirectory.empty())
+		{
+			PageEntry *table = pageDirectory[address >> (PAGE_SHIFT + PAGE_TABLE_BITS)];
+			if (table == NULL)
+				return NULL;
+			PageEntry &entry = table[(address >> PAGE_SHIFT) & (PAGE_TABLE_SIZE - 1)];
+			if (!(entry.kinds & REGION_BINARY))
+				return NULL;
+			if (!entry.shared)
+			{
+				if (entry.owner != NULL && address >= entry.owner->start && address <= entry.owner->end)
+					return entry.owner;
+				return NULL;
+			}
+		}
+		int found = intervalSearch(sectionIndex, address);
+		return found == -1 ? NULL : sectionOrder[found];
+	}
+
+	void flushTLB()
+	{
+		for (int i = 0;i < TLB_ENTRIES;i++)
+		{
+			readTLB[i] = TLBEntry();
+			writeTLB[i] = TLBEntry();
+			execTLB[i] = TLBEntry();
+		}
+		tlbHeapSize = MMUHeap.getHeapSize();
+	}
+
+	TLBEntry &tlbSlot(TLBEntry *tlb, uint64_t address)
+	{
+		return tlb[(address >> TLB_PAGE_SHIFT) & (TLB_ENTRIES - 1)];
+	}
+
+	// Host address for a numBytes access at address, or NULL when the TLB misses.
+	char *tlbLookup(TLBEntry *tlb, uint64_t address, int numBytes)
+	{
+		// A heap allocation can claim addresses that were cached as something else
+		if (MMUHeap.getHeapSize() != tlbHeapSize)
+			flushTLB();
+		TLBEntry &entry = tlbSlot(tlb, address);
+		if (numBytes > TLB_MAX_ACCESS || address < entry.lo || address + numBytes > entry.hi)
+			return NULL;
+		return (char *)(entry.offset + (intptr_t)address);
+	}
+
+	// Shrinks [lo, hi) around address so it stays clear of [start, end].
+	void tlbExclude(uint64_t address, uint64_t &lo, uint64_t &hi, uint64_t start, uint64_t end)
+	{
+		if (end < lo || start >= hi)
+			return;
+		if (end < address)
+			lo = end + 1;
+		else if (start > address)
+			hi = start;
+		else
+			hi = lo;
+	}
+
+	// Caches the stack page around address in tlb, after the slow path found it on the stack.
+	void tlbFillStack(TLBEntry *tlb, uint64_t address)
+	{
+		TLBEntry &entry = tlbSlot(tlb, address);
+		uint64_t lo = address & ~(uint64_t)(TLB_PAGE_SIZE - 1);
+		// The slow path still has to see accesses below stackSize, they grow it
+		lo = max(lo, stackBase - stackSize + 1);
+		lo = max(lo, stackBase - stackMaxLength + 1);
+		entry.lo = max(lo, (uint64_t)1);
+		entry.hi = min((address | (TLB_PAGE_SIZE - 1)) + 1, stackBase);
+		entry.offset = (intptr_t)stackTop - (intptr_t)stackBase;
+	}
+
+	// Caches the part of token around address in tlb. host holds the length bytes of the
+	// section from guest address regionStart on, either one block or the read-only image.
+	void tlbFillSection(TLBEntry *tlb, uint64_t address, section &token, uint64_t regionStart, uint64_t length, char *host)
+	{
+		TLBEntry &entry = tlbSlot(tlb, address);
+		uint64_t lo = max(address & ~(uint64_t)(TLB_PAGE_SIZE - 1), regionStart);
+		uint64_t hi = min((address | (TLB_PAGE_SIZE - 1)) + 1, regionStart + length);
+		hi = min(hi, token.end);
+		tlbExclude(address, lo, hi, 0, 0);
+		tlbExclude(address, lo, hi, stackBase - stackMaxLength + 1, stackBase + 16);
+		tlbExclude(address, lo, hi, MMUHeap.getHeapBase(), MMUHeap.getHeapBase() + MMUHeap.getHeapSize());
+		int k = hi > lo ? intervalFloor(sectionIndex, hi - 1) : -1;
+		for (;k >= 0 && sectionIndex[k].end >= lo;k--)
+		{
+			if (sectionOrder[sectionIndex[k].order]->start != token.start)
+				tlbExclude(address, lo, hi, sectionIndex[k].start, sectionIndex[k].end);
+		}
+		entry.lo = lo;
+		entry.hi = hi;
+		entry.offset = (intptr_t)host - (intptr_t)regionStart;
+	}
+
+	// Same answer as segSearch(address).executable, cached per page.
+	bool isExecutable(uint64_t address)
+	{
+		TLBEntry &entry = tlbSlot(execTLB, address);
+		if (address >= entry.lo && address < entry.hi)
+			return entry.executable;
+		for (int i = 0;i < segments.size();i++)
+		{
+			if (address <= segments[i].end && address >= segments[i].start)
+			{
+				uint64_t lo = max(address & ~(uint64_t)(TLB_PAGE_SIZE - 1), segments[i].start);
+				uint64_t hi = min((address | (TLB_PAGE_SIZE - 1)) + 1, segments[i].end + 1);
+				for (int j = 0;j < segments.size();j++)
+				{
+					if (j != i)
+						tlbExclude(address, lo, hi, segments[j].start, segments[j].end);
+				}
+				entry.lo = lo;
+				entry.hi = hi;
+				entry.executable = segments[i].executable;
+				return entry.executable;
+			}
+		}
+		return false;
+	}
+
+	
+	void secSort()
+	{
+		stable_sort(allSections.begin(), allSections.end());
+	}
+	
+
+	
+	segment segSearch(uint64_t index)
+	{
+		int found = intervalSearch(segmentIndex, index);
+		if (found != -1)
+		{
+			return segments[found];
+		}
+		return segment();
+	}
+
+	//calculates the largest gap between sections
+	//returns the left and right border of the gap
+	gap getLargestGap(bool * excluded = NULL)
+	{
+		
+		if(excluded == NULL)
+		{
+			excluded = (bool *) calloc(allSections.size() + 1, sizeof(bool));
+		}
+		
+		int l=0,r=0;
+		int maxl=0,maxr=0, maxWidth = 0, maxI = 0;
+		
+		for(int i=0;i<allSections.size();i++)
+		{
+			
+			r = allSections[i].start;
+			if(r-l > maxWidth && !excluded[i])
+			{
+				maxWidth = r - l;
+				maxr = r;
+				maxl = l;
+				maxI = i;
+			}
+
+			l = allSections[i].end;
+			
+		}
+		fflush(stdout);
+		r = 0x7fffffff;
+		if(r - l > maxWidth && !excluded[allSections.size()])
+		{
+			maxWidth = r - l;
+			maxr = r;
+			maxl = l;
+			maxI = allSections.size();
+		}
+		gap out;
+
+		out.l = maxl;
+		out.r = maxr;
+		out.rightSection = maxI;
+		fflush(stdout);
+		free(excluded);
+		return out;
+	}
+
+	//Writes to the stack in increasing memory address, last byte of data first, so
+	//little endian host values land big endian.
+	void stackWrite(uint64_t address, char *data, int length)
+	{
+		fflush(stdout);
+		if(stackBase - address + 1 > stackSize)
+		{
+			stackSize = stackBase - address + 1;
+		}
+		noteWrite(address, length);
+		char *out = stackTop - (stackBase - address);
+		for(int i = 0;i < length; i++)
+		{
+			out[i] = data[length - 1 - i];
+		}
+		return;
+	}
+	
+	bool isInStack(uint64_t address, bool expandStack = true)
+	{
+		return (regionKinds(address) & REGION_STACK) && stackContains(address, expandStack);
+	}
+
+	bool stackContains(uint64_t address, bool expandStack)
+	{
+		//printf("stack check address: %x, stackBase %x, stackmaxlength %x", address, stackBase, stackMaxLength);
+		if(expandStack == true && address <= stackBase && address > stackBase - stackMaxLength)
+		{
+			return true;
+		}
+		if(expandStack == false && address <= stackBase && address > stackBase - stackSize)
+		{
+			return true;
+		}
+		return false;
+	}
+	
+	bool isInBinary(uint64_t address)
+	{
+		//For Binja binary accesses	
+		return findSection(address) != NULL;
 	}
 
 	
 	
 	bool isInMemory(uint64_t address, bool expandStack = true)
 	{
-		if(isInStack(address, expandStack))
+		uint8_t kinds = regionKinds(address);
+		if((kinds & REGION_STACK) && stackContains(address, expandStack))
 			return true;
-		if(isInBinary(address))
+		if((kinds & REGION_BINARY) && isInBinary(address))
 			return true;
-		if(MMUHeap.isInHeap(address))
+		if((kinds & REGION_HEAP) && MMUHeap.isInHeap(address))
 			return true;
 		return false;
 	}
@@ -1000,13 +2066,18 @@ class MMU
 		//printf("add, SB, SML : %x, %x, %x\N", address, stackBase, stackMaxLength);
 		
 		//printf("numBytes: [%x]\n", numBytes);
+		char *cached = tlbLookup(readTLB, address, numBytes);
+		if(cached != NULL)
+			return cached;
+
 		if(address == 0)
 		{
 			printf("Null pointer dereference exception\n");
 			return NULL;
 		}
 
-		if((address > stackBase && address <= stackBase + 16) || (address + numBytes > stackBase && address + numBytes <= stackBase + 16))
+		uint8_t kinds = regionKinds(address);
+		if((kinds & (REGION_STACK | REGION_GUARD)) && ((address > stackBase && address <= stackBase + 16) || (address + numBytes > stackBase && address + numBytes <= stackBase + 16)))
 		{
 			printf("Stack Overflow Exception\n");
 			if(outputfile != NULL)
@@ -1021,7 +2092,7 @@ class MMU
 			return NULL;
 		}
 			
-		if(isInStack(address, expandStack) && isInStack(address + numBytes, expandStack))
+		if((kinds & REGION_STACK) && stackContains(address, expandStack) && stackContains(address + numBytes, expandStack))
 		{
 			//printf("Searching the stack! %lld\n", stackBase - address);
 			/*if(contents < stackBase - stack.size())
@@ -1032,90 +2103,89 @@ class MMU
 			{
 				stack.resize(stackBase - address + 1);
 			}*/
-			//printf("\t\t\tstackBase: %x, %d, %x\n", stackBase, stack.size(), address);
-			if(expandStack && address < stackBase - stack.size())
-			{
-				stack.resize(stackBase - address + 8);
-			}
+			//printf("\t\t\tstackBase: %x, %d, %x\n", stackBase, stackSize, address);
+			if(expandStack && address < stackBase - stackSize && !growStack(stackBase - address + 8))
+				return NULL;
+			if(address > stackBase - stackSize)
+				tlbFillStack(readTLB, address);
 
 			uint64_t stackOffset = stackBase - address;
-			//printf("stackData: %x\n", stack.data());
-			return stack.data() + stackOffset;
+			//printf("stackTop: %x\n", stackTop);
+			return stackTop - stackOffset;
 		}
 		//For Heap Pointer access
-		if(MMUHeap.isInHeap(address))
+		if((kinds & REGION_HEAP) && MMUHeap.isInHeap(address))
 		{
 			uint8_t *out = MMUHeap.readHeapMemory(address, numBytes, suppressHeap);
 			
 			return out;
 		}
 		//For Binja binary accesses	
-		//For each segment,
-		for (int i = 0;i < segments.size();i++)
+		section *found = (kinds & REGION_BINARY) ? findSection(address) : NULL;
+		if (found != NULL)
 		{
-			//For each section,
-			for (int j = 0;j < segments[i].sections->size();j++)
+			section token = *found;
+			
+			fflush(stdout);
+			//Is it readable?
+			if (token.readable)
 			{
-				segment tokenHold = segments[i];
-				section token = (*(tokenHold.sections))[j];
-				//Is it valid? (within bounds)
-				if (address >= token.start && address <= token.end)
+				//Is it writable? Exists to avoid loading unwritable data when unnecessary
+				if (token.writable)
 				{
 					
+					//Yes, could have a dirty state in memory:
+					//block access arithmetic, token[depth][blockOffset] should be starting point
+					fflush(stdout);
+					uint64_t offset = address - token.start;
+					uint64_t depth = (int)(offset / token.width);
+					uint64_t blockOffset = offset % token.width;
 					fflush(stdout);
-					//Is it readable?
-					if (token.readable)
+					//Not even initialized, pull and return 
+					if (!token.initialized[depth])
+					{
+						//token[depth] = binja.access(token.start + depth*width, width);
+						if (bv->Read(token.array[depth], address - blockOffset, token.width) != token.width)
+							1 + 1;
+						token.initialized[depth] = true;
+
+					}
+					//printf("[FLUSH] 3\n");
+					if (blockOffset + numBytes > token.width)
+					{
+						printf("Reading past the size of the block.\n");
+						generallyPause();
+					}
+					else
+						tlbFillSection(readTLB, address, token, address - blockOffset, token.width, token.array[depth]);
+					//printf("[FLUSH] %x, %x, %x, %x, %x\n", address, token.start, offset, depth, blockOffset);
+					/*
+					char * testing = token.array[depth];
+					for(int i=0;i<16;i++)
 					{
-						//Is it writable? Exists to avoid loading unwritable data when unnecessary
-						if (token.writable)
-						{
-							
-							//Yes, could have a dirty state in memory:
-							//block access arithmetic, token[depth][blockOffset] should be starting point
-							fflush(stdout);
-							uint64_t offset = address - token.start;
-							uint64_t depth = (int)(offset / token.width);
-							uint64_t blockOffset = offset % token.width;
-							fflush(stdout);
-							//Not even initialized, pull and return 
-							if (!token.initialized[depth])
-							{
-								//token[depth] = binja.access(token.start + depth*width, width);
-								if (bv->Read(token.array[depth], address - blockOffset, token.width) != token.width)
-									1 + 1;
-								token.initialized[depth] = true;
-
-							}
-							//printf("[FLUSH] 3\n");
-							if (blockOffset + numBytes > token.width)
-							{
-								printf("Reading past the size of the block.\n");
-								generallyPause();
-							}
-							//printf("[FLUSH] %x, %x, %x, %x, %x\n", address, token.start, offset, depth, blockOffset);
-							/*
-							char * testing = token.array[depth];
-							for(int i=0;i<16;i++)
-							{
-								printf("%x", testing[i]);
-							}
-							printf("\n");*/
-
-							return token.array[depth] + blockOffset;
-
-
-						}
-						//should just return a pointer to a numBytes-length array of the requested bytes
-						else
-						{
-							char* out = (char*)(calloc(numBytes, sizeof(char)));
-
-							//if(num bytes read by Read() != numBytes)
-							if (bv->Read(out, address, numBytes) != numBytes)
-								generallyPause();
-							return out;
-						}
+						printf("%x", testing[i]);
 					}
+					printf("\n");*/
+
+					return token.array[depth] + blockOffset;
+
+
+				}
+				//Read-only sections are served from the image loaded up front
+				else if (token.image != NULL && address + numBytes <= token.end + 1)
+				{
+					tlbFillSection(readTLB, address, token, token.start, token.length + 1, token.image);
+					return token.image + (address - token.start);
+				}
+				//should just return a pointer to a numBytes-length array of the requested bytes
+				else
+				{
+					char* out = (char*)(calloc(numBytes, sizeof(char)));
+
+					//if(num bytes read by Read() != numBytes)
+					if (bv->Read(out, address, numBytes) != numBytes)
+						generallyPause();
+					return out;
 				}
 			}
 		}
@@ -1129,9 +2199,13 @@ class MMU
 	{
 		//printf("address: %lx, gpr: %d\n", address, gpr);
 		//fflush(stdout);
+		char *cached = tlbLookup(writeTLB, address, numBytes);
+		if(cached != NULL)
+			return cached;
 
+		uint8_t kinds = regionKinds(address);
 		//Stack overflow detection
-		if((address > stackBase && address <= stackBase + 16) || (address + numBytes > stackBase && address + numBytes <= stackBase + 16))
+		if((kinds & (REGION_STACK | REGION_GUARD)) && ((address > stackBase && address <= stackBase + 16) || (address + numBytes > stackBase && address + numBytes <= stackBase + 16)))
 		{
 			printf("Stack Overflow Exception\n");
 			if(outputfile != NULL)
@@ -1144,7 +2218,7 @@ class MMU
 		}
 
 		//For Stack pointer access
-		if(address <= stackBase && address > stackBase - stackMaxLength)
+		if((kinds & REGION_STACK) && stackContains(address, true))
 		{
 			//printf("Searching the stack!\n");
 			//printf("%lx\n", address);
@@ -1157,87 +2231,89 @@ class MMU
 			{
 				stack.resize(stackBase - address + 1);
 			}*/
-			if(address < stackBase - stack.size())
+			if(address < stackBase - stackSize)
 			{
-				//printf("\t\t\tstackBase: %x, %d, %x", stackBase, stack.size(), address);
-				stack.resize(stackBase - address + 8);
+				//printf("\t\t\tstackBase: %x, %d, %x", stackBase, stackSize, address);
+				if(!growStack(stackBase - address + 8))
+					return NULL;
 			}
+			if(!noteWrite(address, numBytes))
+				return NULL;
+			if(address > stackBase - stackSize)
+				tlbFillStack(writeTLB, address);
 
 			uint64_t stackOffset = stackBase - address;
-			//printf("stackData: %x\n", stack.data());
+			//printf("stackTop: %x\n", stackTop);
 			fflush(stdout);
-			return stack.data() + stackOffset;
+			return stackTop - stackOffset;
 		}
 
 		//For Heap Pointer access
-		if(MMUHeap.isInHeap(address))
+		if((kinds & REGION_HEAP) && MMUHeap.isInHeap(address))
 		{
 			uint8_t *out = MMUHeap.writeHeapMemory(address, numBytes);
 			if(out == NULL)
 			{
 				printf("Fail heap write\n");
 			}
+			else if(!noteWrite(address, numBytes))
+				return NULL;
 			return out;
 		}
 		//For Binja binary accesses	
-		//For each segment,
-		for (int i = 0;i < segments.size();i++)
+		section *found = (kinds & REGION_BINARY) ? findSection(address) : NULL;
+		if (found != NULL)
 		{
-			//For each section,
-			for (int j = 0;j < segments[i].sections->size();j++)
+			section token = *found;
+			fflush(stdout);
+			//Is it readable?
+			if (token.readable)
 			{
-				segment tokenHold = segments[i];
-				section token = (*(tokenHold.sections))[j];
-				//Is it valid? (within bounds)
-				if (address >= token.start && address <= token.end)
+				//Is it writable?
+				if (token.writable)
 				{
+					//Yes, could have a dirty state in memory:
+					//block access arithmetic, token[depth][blockOffset] should be starting point
 					fflush(stdout);
-					//Is it readable?
-					if (token.readable)
+					uint64_t offset = address - token.start;
+					uint64_t depth = (int)(offset / token.width);
+					uint64_t blockOffset = offset % token.width;
+					fflush(stdout);
+					//Not even initialized, pull and return 
+					if (!token.initialized[depth])
 					{
-						//Is it writable?
-						if (token.writable)
-						{
-							//Yes, could have a dirty state in memory:
-							//block access arithmetic, token[depth][blockOffset] should be starting point
-							fflush(stdout);
-							uint64_t offset = address - token.start;
-							uint64_t depth = (int)(offset / token.width);
-							uint64_t blockOffset = offset % token.width;
-							fflush(stdout);
-							//Not even initialized, pull and return 
-							if (!token.initialized[depth])
-							{
-								//token[depth] = binja.access(token.start + depth*width, width);
-								//this if is nullified because when bv reads the right edge of a section it doesn't read a full block of data
-								if (bv->Read(token.array[depth], address - blockOffset, token.width) != token.width)
-									1 + 1;
-								token.initialized[depth] = true;
-
-							}
-							//printf("[FLUSH] 3\n");
-							if (blockOffset + numBytes > token.width)
-							{
-								printf("Reading past size of the block.\n");
-								generallyPause();
-							}
-							//printf("[FLUSH] %x, %x, %x, %x, %x\n", address, token.start, offset, depth, blockOffset);
-
-							char * testing = token.array[depth];
-							for(int i=0;i<16;i++)
-							{
-								//printf("%x", testing[i]);
-							}
-							//printf("\n");
-
-							return token.array[depth] + blockOffset;
-						}
-						else
-						{
-							printf("Unwritable Token On Write Exception");
-							return NULL;
-						}
+						//token[depth] = binja.access(token.start + depth*width, width);
+						//this if is nullified because when bv reads the right edge of a section it doesn't read a full block of data
+						if (bv->Read(token.array[depth], address - blockOffset, token.width) != token.width)
+							1 + 1;
+						token.initialized[depth] = true;
+
 					}
+					if(!noteWrite(address, numBytes))
+						return NULL;
+					//printf("[FLUSH] 3\n");
+					if (blockOffset + numBytes > token.width)
+					{
+						printf("Reading past size of the block.\n");
+						generallyPause();
+					}
+					else
+						tlbFillSection(writeTLB, address, token, address - blockOffset, token.width, token.array[depth]);
+					//printf("[FLUSH] %x, %x, %x, %x, %x\n", address, token.start, offset, depth, blockOffset);
+
+					char * testing = token.array[depth];
+					for(int i=0;i<16;i++)
+					{
+						//printf("%x", testing[i]);
+					}
+					//printf("\n");
+
+					return token.array[depth] + blockOffset;
+				}
+				else
+				{
+					printf("Unwritable Token On Write Exception");
+					return NULL;
 				}
 			}
 		}
@@ -1277,49 +2353,564 @@ class MMU
 	{
 		if(memPtr == NULL)
 			return -1;
-		if(isInStack(vAddr))
+		return copyIn(vAddr, inputStream, numBytes) ? 1 : -1;
+	}
+	int readFromMMU(char *memPtr, uint64_t vAddr, char *outputStream, int numBytes)
+	{
+		if(memPtr == NULL || outputStream == NULL)
+			return -1;
+		return copyOut(vAddr, outputStream, numBytes) ? 1 : -1;
+	}
+
+	// Marks the current guest memory as the one restore() goes back to. From here on each
+	// TLB page of the stack, the writable sections and the heap is copied aside the first
+	// time it is written, so restoring costs the pages dirtied rather than the whole image.
+	void snapshot()
+	{
+		discardSnapshot();
+		snapshotTaken = true;
+		snapshotStackSize = stackSize;
+		MMUHeap.snapshot();
+		// Pages already in the write TLB would be written without being journaled
+		flushTLB();
+	}
+
+	// Copies the journaled pages back. The snapshot stays, so it can be restored again.
+	// A limit exceeded since is forgotten along with the memory that exceeded it.
+	bool restore()
+	{
+		if(!snapshotTaken)
+			return false;
+		for(SavedRange &saved : journal)
+			memcpy(saved.host, saved.bytes.data(), saved.bytes.size());
+		journal.clear();
+		journaledPages.clear();
+		stackSize = snapshotStackSize;
+		limitHit = LIMIT_NONE;
+		MMUHeap.restore();
+		flushTLB();
+		return true;
+	}
+
+	void discardSnapshot()
+	{
+		snapshotTaken = false;
+		journal.clear();
+		journaledPages.clear();
+		MMUHeap.discardSnapshot();
+	}
+
+	// Called by the write path once [address, address + numBytes) has been found writable,
+	// before it is written, so a faulting write is neither marked nor counted. Marks the
+	// TLB pages under it dirty and, after snapshot(), saves the ones not journaled yet. A
+	// write TLB entry never spans more than one of those pages, so whatever is written
+	// through the TLB afterwards is already covered. The heap tracks its own pages. False
+	// when the write would take the MMU past one of its limits.
+	bool noteWrite(uint64_t address, uint64_t numBytes)
+	{
+		if(numBytes == 0)
+			return true;
+		for(uint64_t page = address >> TLB_PAGE_SHIFT; page <= (address + numBytes - 1) >> TLB_PAGE_SHIFT; page++)
 		{
-			int k=numBytes-1;
-			numBytes *= -1;
-			for(int i=0;i > numBytes; i--)
+			bool journaling = snapshotTaken && journaledPages.insert(page).second;
+			uint64_t lo = page << TLB_PAGE_SHIFT;
+			uint64_t hi = lo + TLB_PAGE_SIZE;
+			uint64_t stackLo = max(lo, stackBase - stackMaxLength + 1);
+			uint64_t stackHi = min(hi, stackBase + 1);
+			if(stackLo < stackHi)
 			{
-				memPtr[i] = inputStream[k];
-				k--;
+				uint64_t stackPage = page - ((stackBase - stackMaxLength + 1) >> TLB_PAGE_SHIFT);
+				dirtyCount += !stackDirty[stackPage];
+				stackDirty[stackPage] = true;
+				if(journaling)
+					journalHost(stackTop - (stackBase - stackLo), stackHi - stackLo);
+			}
+			for(int k = intervalFloor(sectionIndex, hi - 1);k >= 0 && sectionIndex[k].end >= lo;k--)
+			{
+				section *token = sectionOrder[sectionIndex[k].order];
+				if(!token->writable || token->image != NULL)
+					continue;
+				uint64_t sectionLo = max(lo, token->start);
+				uint64_t sectionHi = min(hi, token->end + 1);
+				if(sectionLo >= sectionHi)
+					continue;
+				for(uint64_t depth = (sectionLo - token->start) / token->width; depth <= (sectionHi - 1 - token->start) / token->width; depth++)
+				{
+					dirtyCount += !token->writtenTo[depth];
+					token->writtenTo[depth] = true;
+				}
+				if(journaling)
+					journalSection(token, sectionLo, sectionHi);
 			}
-			return 1;
 		}
-		else
+		return checkLimits();
+	}
+
+	// Raises stackSize to size unless that passes the stack limit.
+	bool growStack(uint64_t size)
+	{
+		if(limits.stackBytes != 0 && size > limits.stackBytes)
+			return exceedLimit(LIMIT_STACK);
+		stackSize = size;
+		return true;
+	}
+
+	// What this MMU uses right now. The host RSS is that of the whole process.
+	ResourceCounters usage()
+	{
+		ResourceCounters now;
+		now.heapBytes = MMUHeap.getHeapSize();
+		now.stackBytes = stackSize;
+		now.dirtyPages = dirtyCount + MMUHeap.getDirtyCount();
+		now.rssBytes = hostRSS();
+		return now;
+	}
+
+	// Printed on every way out of the emulator, and by the console's usage command.
+	void printUsage()
+	{
+		ResourceCounters now = usage();
+		printf("Resource usage: heap 0x%lx bytes, stack 0x%lx bytes, %lu dirty pages, host RSS %lu KiB\n",
+			now.heapBytes, now.stackBytes, now.dirtyPages, now.rssBytes / 1024);
+		// Most ways out end in SIGKILL, which would drop anything still buffered
+		fflush(stdout);
+		if(outputfile != NULL)
 		{
-			for(int i=0;i<numBytes;i++)
-				memPtr[i] = inputStream[i];
-			return 1;
+			FILE *file = fopen(outputfile, "a");
+			fprintf(file, "Resource usage: heap 0x%lx bytes, stack 0x%lx bytes, %lu dirty pages, host RSS %lu KiB\n",
+				now.heapBytes, now.stackBytes, now.dirtyPages, now.rssBytes / 1024);
+			fclose(file);
 		}
 	}
-	int readFromMMU(char *memPtr, uint64_t vAddr, char *outputStream, int numBytes)
+
+	static uint64_t hostRSS()
 	{
-		if(memPtr == NULL || outputStream == NULL)
-			return -1;
-		if(isInStack(vAddr))
+		uint64_t pages = 0, resident = 0;
+		FILE *statm = fopen("/proc/self/statm", "r");
+		if(statm == NULL)
+			return 0;
+		if(fscanf(statm, "%lu %lu", &pages, &resident) != 2)
+			resident = 0;
+		fclose(statm);
+		return resident * sysconf(_SC_PAGESIZE);
+	}
+
+	// False once any limit has been exceeded: the heap refused an allocation under its cap,
+	// or too many pages are dirty, or the host RSS is over its cap. The RSS is only read
+	// every RSS_CHECK_INTERVAL calls. The heap and stack caps are also enforced where they
+	// grow, see the Heap constructor call and growStack.
+	bool checkLimits()
+	{
+		if(limitHit != LIMIT_NONE)
+			return false;
+		if(limits.heapBytes != 0 && MMUHeap.lastAllocationRefused())
+			return exceedLimit(LIMIT_HEAP);
+		if(limits.dirtyPages != 0 && dirtyCount + MMUHeap.getDirtyCount() > limits.dirtyPages)
+			return exceedLimit(LIMIT_DIRTY);
+		if(limits.rssBytes != 0 && ++limitChecks % RSS_CHECK_INTERVAL == 0 && hostRSS() > limits.rssBytes)
+			return exceedLimit(LIMIT_RSS);
+		return true;
+	}
+
+	bool exceedLimit(int limit)
+	{
+		limitHit = limit;
+		printf("Resource Limit Exceeded: %s\n", limitNames[limit]);
+		if(outputfile != NULL)
+		{
+			FILE *file = fopen(outputfile, "a");
+			fprintf(file, "Resource Limit Exceeded: %s\n", limitNames[limit]);
+			fclose(file);
+		}
+		return false;
+	}
+
+	static uint32_t corePermissions(section *token)
+	{
+		return (token->readable ? R : 0) | (token->writable ? W : 0) | (token->executable ? X : 0);
+	}
+
+	// FNV-1a hash of the number of sections and the extent and permissions of each, which
+	// with the entry point tells a core file of this binary from one of another.
+	uint64_t layoutHash()
+	{
+		uint64_t hash = 0xcbf29ce484222325ULL;
+		auto mix = [&](uint64_t value) {
+			for(int i = 0;i < 8;i++)
+			{
+				hash ^= (value >> (8 * i)) & 0xff;
+				hash *= 0x100000001b3ULL;
+			}
+		};
+		mix(sectionOrder.size());
+		for(section *token : sectionOrder)
 		{
-			numBytes *= -1;
-			int k=0;
-			for(int i=0;i > numBytes; i--)
+			mix(token->start);
+			mix(token->length);
+			mix(corePermissions(token));
+		}
+		return hash;
+	}
+
+	// Streams everything mapped to fp as core file regions: every section with its
+	// permissions, the part of the stack the program has reached and the heap. Writable
+	// blocks never loaded are written as the binary has them, so a core stands on its own.
+	bool writeCore(FILE *fp)
+	{
+		for(section *token : sectionOrder)
+		{
+			CoreRegion region = {token->start, (uint64_t)token->length + 1, CORE_SECTION, corePermissions(token)};
+			fwrite(&region, sizeof(region), 1, fp);
+			if(token->writable && token->image == NULL)
 			{
-				outputStream[k] = memPtr[i];
-				k++;
+				char *unloaded = NULL;
+				for(uint64_t depth = 0;depth <= token->length / token->width;depth++)
+				{
+					uint64_t blockStart = token->start + depth * token->width;
+					if(blockStart > token->end)
+						break;
+					char *block = token->array[depth];
+					if(!token->initialized[depth])
+					{
+						if(unloaded == NULL)
+							unloaded = (char *) calloc(token->width, sizeof(char));
+						memset(unloaded, 0, token->width);
+						bv->Read(unloaded, blockStart, token->width);
+						block = unloaded;
+					}
+					writeCoreChunks(fp, blockStart, block, min((uint64_t)token->width, token->end + 1 - blockStart));
+				}
+				free(unloaded);
 			}
-			return 1;
+			endCoreRegion(fp);
 		}
-		else
+
+		uint64_t stackLength = min(stackSize, stackMaxLength);
+		CoreRegion stack = {stackBase - stackLength + 1, stackLength, CORE_STACK, R | W};
+		fwrite(&stack, sizeof(stack), 1, fp);
+		writeCoreChunks(fp, stack.start, stackTop - (stackLength - 1), stackLength);
+		endCoreRegion(fp);
+
+		MMUHeap.writeCore(fp);
+
+		CoreRegion end = {0, 0, CORE_END, 0};
+		fwrite(&end, sizeof(end), 1, fp);
+		return ferror(fp) == 0;
+	}
+
+	// Loads the regions writeCore wrote into this MMU, which must be built from the same
+	// binary. The snapshot journal and the dirty bits start over.
+	bool readCore(FILE *fp)
+	{
+		int next = 0;
+		CoreRegion region;
+		while(fread(&region, sizeof(region), 1, fp) == 1)
 		{
-			for(int i=0;i<numBytes;i++)
-				outputStream[i] = memPtr[i];
-			return 1;
+			if(region.kind == CORE_END)
+			{
+				discardSnapshot();
+				clearDirty();
+				return true;
+			}
+			if(region.kind == CORE_SECTION)
+			{
+				if(next >= sectionOrder.size() || sectionOrder[next]->start != region.start
+				   || region.length != (uint64_t)sectionOrder[next]->length + 1
+				   || region.permissions != corePermissions(sectionOrder[next]))
+					return false;
+				section *token = sectionOrder[next++];
+				bool writable = token->writable && token->image == NULL;
+				if(writable)
+				{
+					for(uint64_t depth = 0;depth <= token->length / token->width;depth++)
+					{
+						memset(token->array[depth], 0, token->width);
+						token->initialized[depth] = true;
+					}
+				}
+				bool read = readCoreChunks(fp, region, [&](uint64_t address, const char *bytes, uint64_t length) {
+					while(writable && length > 0)
+					{
+						uint64_t offset = address - token->start;
+						uint64_t piece = min(length, (uint64_t)token->width - offset % token->width);
+						memcpy(token->array[offset / token->width] + offset % token->width, bytes, piece);
+						address += piece;
+						bytes += piece;
+						length -= piece;
+					}
+				});
+				if(!read)
+					return false;
+			}
+			else if(region.kind == CORE_STACK)
+			{
+				if(region.length > stackMaxLength || region.start + region.length != stackBase + 1)
+					return false;
+				uint64_t cleared = min(max(stackSize, region.length), stackMaxLength);
+				memset(stackTop - (cleared - 1), 0, cleared);
+				stackSize = region.length;
+				bool read = readCoreChunks(fp, region, [&](uint64_t address, const char *bytes, uint64_t length) {
+					memcpy(stackTop - (stackBase - address), bytes, length);
+				});
+				if(!read)
+					return false;
+			}
+			else if(region.kind != CORE_HEAP || !MMUHeap.readCore(fp, region))
+				return false;
 		}
+		return false;
 	}
 
+	// Calls visit(address, length) for every range of guest memory written since
+	// clearDirty(): whole blocks of the writable sections, TLB pages of the stack and heap.
+	// Restoring, hashing or diffing these is enough to cover everything a run changed.
+	template <class F>
+	void forEachDirty(F visit)
+	{
+		for(section *token : sectionOrder)
+		{
+			if(!token->writable || token->image != NULL)
+				continue;
+			for(uint64_t depth = 0;depth <= token->length / token->width;depth++)
+			{
+				uint64_t blockStart = token->start + depth * token->width;
+				if(token->writtenTo[depth] && blockStart <= token->end)
+					visit(blockStart, min((uint64_t)token->width, token->end + 1 - blockStart));
+			}
+		}
+		uint64_t stackLow = stackBase - stackMaxLength + 1;
+		for(uint64_t i = 0;i < stackDirty.size();i++)
+		{
+			if(!stackDirty[i])
+				continue;
+			uint64_t lo = max(((stackLow >> TLB_PAGE_SHIFT) + i) << TLB_PAGE_SHIFT, stackLow);
+			uint64_t hi = min((((stackLow >> TLB_PAGE_SHIFT) + i + 1) << TLB_PAGE_SHIFT), stackBase + 1);
+			visit(lo, hi - lo);
+		}
+		MMUHeap.forEachDirty(visit);
+	}
+
+	void clearDirty()
+	{
+		for(section *token : sectionOrder)
+			memset(token->writtenTo, 0, (token->length / token->width + 1) * sizeof(bool));
+		stackDirty.assign(stackDirty.size(), false);
+		dirtyCount = 0;
+		MMUHeap.clearDirty();
+		// Pages in the write TLB would be written without being marked again
+		flushTLB();
+	}
+
+	// Saves [lo, hi) of a writable section, one block at a time. A block still waiting for
+	// its lazy load is read first, or the journal would save zeros in place of the binary.
+	void journalSection(section *token, uint64_t lo, uint64_t hi)
+	{
+		while(lo < hi)
+		{
+			uint64_t offset = lo - token->start;
+			uint64_t length = min(hi - lo, (uint64_t)token->width - offset % token->width);
+			uint64_t depth = offset / token->width;
+			if(!token->initialized[depth])
+			{
+				bv->Read(token->array[depth], token->start + depth * token->width, token->width);
+				token->initialized[depth] = true;
+			}
+			journalHost(token->array[offset / token->width] + offset % token->width, length);
+			lo += length;
+		}
+	}
+
+	void journalHost(char *host, uint64_t length)
+	{
+		journal.push_back({host, vector<char>(host, host + length)});
+	}
+
+	// How many bytes from address on a single getEffectiveAddress or getWriteAddresss
+	// pointer covers: to the top of the stack, the end of the heap, or the end of the
+	// section block or read-only image. 0 when address is in none of them.
+	uint64_t contiguousBytes(uint64_t address)
+	{
+		if(address > stackBase && address <= stackBase + 16)
+			return 0;
+		if(address <= stackBase && address > stackBase - stackMaxLength)
+			return stackBase - address + 1;
+		if(MMUHeap.isInHeap(address))
+		{
+			uint64_t heapEnd = MMUHeap.getHeapBase() + MMUHeap.getHeapSize();
+			return address + 1 < heapEnd ? heapEnd - address - 1 : 0;
+		}
+		section *token = findSection(address);
+		if(token == NULL)
+			return 0;
+		if(token->image != NULL)
+			return token->end + 1 - address;
+		uint64_t blockOffset = (address - token->start) % token->width;
+		return min((uint64_t)token->width - blockOffset, token->end + 1 - address);
+	}
+
+	// Bulk guest memory operations. The range is split wherever host memory stops being
+	// contiguous, so it may cross blocks, sections and regions, and each piece gets the
+	// usual permission, stack and heap checks once before a host memcpy, memset, memchr or
+	// memcmp runs over it. They return false (or -1) when any piece faults.
+
+	// Calls visit(host, length) on each checked piece of [address, address + length) until
+	// it returns false.
+	template <class F>
+	bool forEachReadChunk(uint64_t address, uint64_t length, bool suppressHeap, F visit)
+	{
+		while(length > 0)
+		{
+			uint64_t chunk = min(length, contiguousBytes(address));
+			// Let getEffectiveAddress report whatever is wrong with the address
+			if(chunk == 0)
+				chunk = length;
+			char *bytes = getEffectiveAddress(address, chunk, 0, 0, suppressHeap);
+			if(bytes == NULL)
+				return false;
+			if(!visit(bytes, chunk))
+				return true;
+			address += chunk;
+			length -= chunk;
+		}
+		return true;
+	}
+
+	template <class F>
+	bool forEachWriteChunk(uint64_t address, uint64_t length, F visit)
+	{
+		while(length > 0)
+		{
+			uint64_t chunk = min(length, contiguousBytes(address));
+			if(chunk == 0)
+				chunk = length;
+			char *bytes = getWriteAddresss(address, chunk, 0);
+			if(bytes == NULL)
+				return false;
+			visit(bytes, chunk);
+			address += chunk;
+			length -= chunk;
+		}
+		return true;
+	}
+
+	bool copyOut(uint64_t address, char *out, uint64_t length, bool suppressHeap = false)
+	{
+		return forEachReadChunk(address, length, suppressHeap, [&](char *bytes, uint64_t chunk) {
+			memcpy(out, bytes, chunk);
+			out += chunk;
+			return true;
+		});
+	}
+
+	bool copyIn(uint64_t address, const char *in, uint64_t length)
+	{
+		return forEachWriteChunk(address, length, [&](char *bytes, uint64_t chunk) {
+			memcpy(bytes, in, chunk);
+			in += chunk;
+		});
+	}
+
+	bool fill(uint64_t address, uint8_t value, uint64_t length)
+	{
+		return forEachWriteChunk(address, length, [&](char *bytes, uint64_t chunk) {
+			memset(bytes, value, chunk);
+		});
+	}
+
+	// Like memcmp between length guest bytes at address and data; the result is left in
+	// result. Stops checking at the first piece that differs.
+	bool compare(uint64_t address, const char *data, uint64_t length, int &result, bool suppressHeap = false)
+	{
+		result = 0;
+		return forEachReadChunk(address, length, suppressHeap, [&](char *bytes, uint64_t chunk) {
+			result = memcmp(bytes, data, chunk);
+			data += chunk;
+			return result == 0;
+		});
+	}
+
+	// Offset of the first byte equal to value in [address, address + length), length when
+	// there is none, -1 on a fault. Only the bytes up to the match get the read checks, so
+	// scanning past the end of a heap string into uninitialized memory is not an error.
+	int64_t memchr(uint64_t address, uint8_t value, uint64_t length, bool suppressHeap = false)
+	{
+		uint64_t offset = 0;
+		while(offset < length)
+		{
+			uint64_t at = address + offset;
+			uint64_t chunk = min(length - offset, contiguousBytes(at));
+			// Not a fault unless getEffectiveAddress says so, otherwise the byte is a piece
+			if(chunk == 0)
+			{
+				if(getEffectiveAddress(at, 1, 0, 0, suppressHeap) == NULL)
+					return -1;
+				chunk = 1;
+			}
+			// Find the match in the raw bytes, then check only what was used
+			char *raw = MMUHeap.isInHeap(at) ? (char *)MMUHeap.peekHeapMemory(at) : getEffectiveAddress(at, 1, 0, 0, true);
+			if(raw == NULL)
+				return -1;
+			char *match = (char *)::memchr(raw, value, chunk);
+			uint64_t used = match == NULL ? chunk : match - raw + 1;
+			if(getEffectiveAddress(at, used, 0, 0, suppressHeap) == NULL)
+				return -1;
+			if(match != NULL)
+				return offset + used - 1;
+			offset += chunk;
+		}
+		return length;
+	}
+
+	// Length of the string at address, at most maxLength, like strnlen. -1 on a fault.
+	int64_t strnlen(uint64_t address, uint64_t maxLength, bool suppressHeap = false)
+	{
+		return memchr(address, 0, maxLength, suppressHeap);
+	}
+
+	// Typed guest accesses for the load and store handlers. A TLB hit is a copy and a byte
+	// swap; anything else goes through copyOut or copyIn, which make the usual
+	// permission, stack and heap checks and cope with accesses straddling a block. They
+	// return false when the access faults.
+	template <class T>
+	bool load(uint64_t address, T &value, bool suppressHeap = false)
+	{
+		T raw;
+		char *bytes = tlbLookup(readTLB, address, sizeof(T));
+		if(bytes != NULL)
+			memcpy(&raw, bytes, sizeof(T));
+		else if(!copyOut(address, (char *)&raw, sizeof(T), suppressHeap))
+			return false;
+		value = bigEndian(raw);
+		return true;
+	}
+
+	template <class T>
+	bool store(uint64_t address, T value)
+	{
+		T raw = bigEndian(value);
+		char *bytes = tlbLookup(writeTLB, address, sizeof(T));
+		if(bytes != NULL)
+			memcpy(bytes, &raw, sizeof(T));
+		else if(!copyIn(address, (char *)&raw, sizeof(T)))
+			return false;
+		return true;
+	}
+
+	bool load8(uint64_t address, uint8_t &value, bool suppressHeap = false) { return load(address, value, suppressHeap); }
+	bool load16(uint64_t address, uint16_t &value, bool suppressHeap = false) { return load(address, value, suppressHeap); }
+	bool load32(uint64_t address, uint32_t &value, bool suppressHeap = false) { return load(address, value, suppressHeap); }
+	bool load64(uint64_t address, uint64_t &value, bool suppressHeap = false) { return load(address, value, suppressHeap); }
+	bool store8(uint64_t address, uint8_t value) { return store(address, value); }
+	bool store16(uint64_t address, uint16_t value) { return store(address, value); }
+	bool store32(uint64_t address, uint32_t value) { return store(address, value); }
+	bool store64(uint64_t address, uint64_t value) { return store(address, value); }
+
 	unsigned char* getBytes(int addr)
 	{	
+		section *found = findSection(addr);
+		if(found != NULL && found->image != NULL && addr + 4 <= found->end + 1)
+			return (unsigned char*) found->image + (addr - found->start);
+
 		if(bv == NULL)
 		{
 			printf("Binary View is not initalized in this getBytes call!\n");
@@ -1423,6 +3014,7 @@ class MMU
 			scanf("%s", pweasenosteppy);
 			if(strncmp(pweasenosteppy, "exit", 4) == 0)
 			{
+				printUsage();
 				raise(SIGKILL);
 			}
 		}
@@ -33,7 +33,8 @@ public:
 	char** array;
 	int width;
 	bool* initialized;
-	bool* writtenTo;
+	bool* writtenTo; // Blocks written since MMU::clearDirty
+	char* image; // Whole section, loaded once, for read-only sections
 	section(int start, int length, char permissions, int width, char *name, segment parent);
 	section()
 	{
@@ -41,6 +42,7 @@ public:
 		this->length = 0;
 		this->end = 0;
 		this->width = 0;
+		this->image = NULL;
 		this->setPerms(0);
 		ID = 0;
 	}